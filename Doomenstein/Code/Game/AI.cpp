@@ -9,10 +9,22 @@
 AI::AI(ActorDefinition::AIInfo aiInfo)
 	: m_staggerDuration(aiInfo.m_staggerSeconds)
 	, m_damageThreshold(aiInfo.m_staggerDamageThreshold)
+	, m_behavior(aiInfo.m_behavior)
 {
 
 }
 
+AI::~AI()
+{
+	ReleaseChaseField();
+}
+
+void AI::SetFleeDirection(Vec2 const& fleeDirection)
+{
+	m_fleeDirection = fleeDirection;
+	m_hasFleeDirection = true;
+}
+
 Controller::Type AI::GetType() const
 {
 	return Type::AI;
@@ -39,6 +51,9 @@ void AI::Update(float deltaSeconds)
 	case AIState::FLEE:
 		HandleFleeState(deltaSeconds);
 		break;
+	case AIState::CHASE:
+		HandleChaseState(deltaSeconds);
+		break;
 	case AIState::STAGGER:
 		HandleStaggerState(deltaSeconds);
 		break;
@@ -122,18 +137,74 @@ void AI::HandleIdleState(float deltaSeconds)
 	Actor* currentTargetActor = m_map->GetActorByHandle(m_targetActorHandle);
 	if (currentTargetActor == nullptr)
 	{
-		// no target: Search
-		Actor* newTargetActor = m_map->GetClosestVisibleEnemy(controlledActor);
-		if (newTargetActor != nullptr)
+		// no target: Search, the result comes back after the actor update
+		if (!m_isSightQueryPending)
 		{
-			m_targetActorHandle = newTargetActor->m_handle;
-			m_currentState = AIState::FLEE;
-			g_theAudio->StartSoundAt(Sound::AI_ALERT, controlledActor->GetEyePosition());
+			SubmitSightQuery(controlledActor);
 		}
 	}
 	else
 	{
-		m_currentState = AIState::FLEE;
+		m_currentState = GetAlertState();
+		g_theAudio->StartSoundAt(Sound::AI_ALERT, controlledActor->GetEyePosition());
+	}
+}
+
+void AI::SubmitSightQuery(Actor* controlledActor)
+{
+	m_isSightQueryPending = true;
+
+	Map* map = m_map;
+	AI* self = this;
+	ActorHandle selfHandle = controlledActor->m_handle;
+	ActorDefinition::AIInfo const& aiInfo = controlledActor->m_definition->m_ai;
+	map->m_spatialQueries.SubmitSectorInSight(selfHandle, Vec2(controlledActor->m_position.x, controlledActor->m_position.y), controlledActor->GetForwardNormal2D(),
+		aiInfo.m_sightAngle, aiInfo.m_sightRadius, controlledActor->GetEyePosition(), [map, self, selfHandle](SpatialQueryResult const& result)
+		{
+			// Queries resolve before any actor is deleted, so the AI is still alive here. The flag is cleared either way,
+			// only the target selection waits for the AI to control its actor again
+			self->m_isSightQueryPending = false;
+
+			// The actor may have been possessed by someone else in the meantime
+			Actor* selfActor = map->GetActorByHandle(selfHandle);
+			if (selfActor != nullptr && selfActor->m_controller == self)
+			{
+				self->OnSightQueryResolved(result);
+			}
+		});
+}
+
+void AI::OnSightQueryResolved(SpatialQueryResult const& result)
+{
+	Actor* controlledActor = GetActor();
+	if (controlledActor == nullptr || m_currentState != AIState::IDLE || m_map->GetActorByHandle(m_targetActorHandle) != nullptr)
+	{
+		return;
+	}
+
+	// Closest visible enemy
+	Actor* newTargetActor = nullptr;
+	float closestDistanceSquared = 100000000.f;
+	for (ActorHandle const& actorHandle : result.m_actors)
+	{
+		Actor* actor = m_map->GetActorByHandle(actorHandle);
+		if (!m_map->IsAlive(actor))
+		{
+			continue;
+		}
+		Vec3 disp = actor->m_position - controlledActor->m_position;
+		float distanceXYSquared = Vec2(disp.x, disp.y).GetLengthSquared();
+		if (distanceXYSquared < closestDistanceSquared)
+		{
+			newTargetActor = actor;
+			closestDistanceSquared = distanceXYSquared;
+		}
+	}
+
+	if (newTargetActor != nullptr)
+	{
+		m_targetActorHandle = newTargetActor->m_handle;
+		m_currentState = GetAlertState();
 		g_theAudio->StartSoundAt(Sound::AI_ALERT, controlledActor->GetEyePosition());
 	}
 }
@@ -156,7 +227,13 @@ void AI::HandleFleeState(float deltaSeconds)
 		return;
 	}
 
-	Vec2 moveDirection = m_map->GetBilinearInterpResultFromWorldPos(Vec2(controlledActor->m_position.x, controlledActor->m_position.y));
+	// Batched by the map when possible
+	Vec2 moveDirection = m_fleeDirection;
+	if (!m_hasFleeDirection)
+	{
+		moveDirection = m_map->GetBilinearInterpResultFromWorldPos(Vec2(controlledActor->m_position.x, controlledActor->m_position.y));
+	}
+	m_hasFleeDirection = false;
 	controlledActor->TurnInDirection(moveDirection.GetOrientationDegrees(), deltaSeconds * controlledActor->m_definition->m_physics.m_turnSpeed);
 	controlledActor->MoveInDirection(Vec3(moveDirection), controlledActor->m_definition->m_physics.m_runSpeed);
 	//Vec2 selfForward2D = controlledActor->GetForwardNormal2D();
@@ -173,11 +250,82 @@ void AI::HandleStaggerState(float deltaSeconds)
 		if (m_staggerTimer < 0.f)
 		{
 			selfActor->m_isStaggering = false;
-			m_currentState = AIState::FLEE;
+			m_currentState = GetAlertState();
 		}
 	}
 }
 
+void AI::HandleChaseState(float deltaSeconds)
+{
+	Actor* controlledActor = GetActor();
+	if (controlledActor == nullptr)
+	{
+		return;
+	}
+	// No target, back to idle
+	Actor* currentTargetActor = m_map->GetActorByHandle(m_targetActorHandle);
+	if (currentTargetActor == nullptr || currentTargetActor->m_isDead)
+	{
+		ReleaseChaseField();
+		m_targetActorHandle = ActorHandle::INVALID;
+		m_currentState = AIState::IDLE;
+		return;
+	}
+
+	Vec2 selfPosition = Vec2(controlledActor->m_position.x, controlledActor->m_position.y);
+	Vec2 targetPosition = Vec2(currentTargetActor->m_position.x, currentTargetActor->m_position.y);
+	Vec2 toTarget = targetPosition - selfPosition;
+	float turnDegrees = deltaSeconds * controlledActor->m_definition->m_physics.m_turnSpeed;
+	IntVec2 selfTile = m_map->GetCoordsForWorldPos(selfPosition.x, selfPosition.y);
+	IntVec2 goalTile = m_map->GetCoordsForWorldPos(targetPosition.x, targetPosition.y);
+	if (!m_map->AreTilesConnected(selfTile, goalTile))
+	{
+		// No walkable path to the target, e.g. it is in another arena: hold position and face it
+		ReleaseChaseField();
+		controlledActor->TurnInDirection(toTarget.GetOrientationDegrees(), turnDegrees);
+		return;
+	}
+	if (m_chaseFieldId < 0 || goalTile != m_chaseGoalTile)
+	{
+		// Acquire before release, a field this actor shares with others is never rebuilt in between
+		int newChaseFieldId = m_map->AcquireChaseField(std::vector<IntVec2>{ goalTile });
+		ReleaseChaseField();
+		m_chaseFieldId = newChaseFieldId;
+		m_chaseGoalTile = goalTile;
+	}
+
+	float attackRange = controlledActor->GetAttackRange() + currentTargetActor->m_definition->m_collision.m_physicsRadius;
+	if (toTarget.GetLengthSquared() <= attackRange * attackRange)
+	{
+		controlledActor->TurnInDirection(toTarget.GetOrientationDegrees(), turnDegrees);
+		controlledActor->Attack();
+		return;
+	}
+
+	// Same tile as the target: the field is flat there, head straight at it
+	Vec2 moveDirection = toTarget.GetNormalized();
+	if (selfTile != goalTile)
+	{
+		moveDirection = m_map->GetChaseDirectionFromWorldPos(m_chaseFieldId, selfPosition);
+	}
+	controlledActor->TurnInDirection(moveDirection.GetOrientationDegrees(), turnDegrees);
+	controlledActor->MoveInDirection(Vec3(moveDirection), controlledActor->m_definition->m_physics.m_runSpeed);
+}
+
+void AI::ReleaseChaseField()
+{
+	if (m_chaseFieldId >= 0 && m_map != nullptr)
+	{
+		m_map->ReleaseChaseField(m_chaseFieldId);
+	}
+	m_chaseFieldId = -1;
+}
+
+AIState AI::GetAlertState() const
+{
+	return (m_behavior == AIBehavior::MELEE) ? AIState::CHASE : AIState::FLEE;
+}
+
 //void AI::TransitionToState(AIState newState)
 //{
 //	if (m_currentState == newState)
@@ -2,10 +2,13 @@
 #include "Game/Controller.hpp"
 #include "Game/ActorDefinition.hpp"
 
+struct SpatialQueryResult;
+
 enum class AIState
 {
 	IDLE,
 	FLEE,
+	CHASE,
 	STAGGER,
 };
 
@@ -14,10 +17,14 @@ class AI : public Controller
 {
 public:
 	AI(ActorDefinition::AIInfo aiInfo);
+	~AI();
 	Type GetType() const override;
 	
 	void Update(float deltaSeconds) override;
 	void DamagedBy(float damangeAmount, Actor* damageCauser);
+	bool IsFleeing() const { return m_currentState == AIState::FLEE; }
+	void SetFleeDirection(Vec2 const& fleeDirection); // batched steering from Map::UpdateFleeSteering, used by the next flee update
+	void SetBehavior(AIBehavior behavior) { m_behavior = behavior; } // spawn override of the definition's behavior
 
 
 public:
@@ -29,9 +36,16 @@ protected:
 private:
 	// Coward AI
 	void HandleIdleState(float deltaSeconds);
+	void SubmitSightQuery(Actor* controlledActor);
+	void OnSightQueryResolved(SpatialQueryResult const& result); // closest visible enemy becomes the target
 	void HandleFleeState(float deltaSeconds);
 	void HandleStaggerState(float deltaSeconds);
 
+	// Melee AI
+	void HandleChaseState(float deltaSeconds);
+	void ReleaseChaseField();
+	AIState GetAlertState() const; // state to enter once a target is found
+
 	//void TransitionToState(AIState newState);
 
 private:
@@ -39,5 +53,11 @@ private:
 	float m_staggerTimer = 0.f;
 	float const m_damageThreshold = 30.f; // will be changed by actor definition
 	float m_accumulatedDamange = 0.f;
+	AIBehavior m_behavior = AIBehavior::COWARD;
+	int m_chaseFieldId = -1; // shared field held by the map, -1 = none
+	IntVec2 m_chaseGoalTile;
+	Vec2 m_fleeDirection;
+	bool m_hasFleeDirection = false;
+	bool m_isSightQueryPending = false;
 };
 
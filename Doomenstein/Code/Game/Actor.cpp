@@ -1,6 +1,7 @@
 #include "Game/Actor.hpp"
 #include "Game/Weapon.hpp"
 #include "Game/AI.hpp"
+#include "Game/Map.hpp"
 #include "Game/Game.hpp"
 #include "Game/Player.hpp"
 #include "Game/MapDefinition.hpp"
@@ -18,17 +19,17 @@
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/VertexBuffer.hpp"
 #include "Engine/Renderer/IndexBuffer.hpp"
+#include <new>
 #include <vector>
 
-Actor::Actor(Map* map, SpawnInfo const& spawnInfo, ActorHandle handle)
+Actor::Actor(Map* map, SpawnInfo const& spawnInfo, ActorDefinition const* definition, ActorHandle handle)
 	: m_map(map)
 	, m_handle(handle)
+	, m_definition(definition)
 	, m_position(spawnInfo.m_position)
 	, m_orientation(spawnInfo.m_orientation)
-	, m_velocity(spawnInfo.m_velocity)
+	, m_animationClock(*(g_theGame->m_clock))
 {
-	m_definition = ActorDefinition::GetByName(spawnInfo.m_actor);
-	m_animationClock = new Clock(*(g_theGame->m_clock));
 	m_currentAnimationGroup = m_definition->GetDefaultAnimationGroup();
 
 	if (m_definition->m_dieOnSpawn)
@@ -37,11 +38,12 @@ Actor::Actor(Map* map, SpawnInfo const& spawnInfo, ActorHandle handle)
 	}
 
 	// load weapons
-	for (std::string weaponName : m_definition->m_inventory.m_weapons)
+	for (WeaponDefinition const* weaponDefinition : m_definition->m_inventory.m_weaponDefinitions)
 	{
-		m_weapons.push_back(new Weapon(weaponName));
+		m_weapons[m_numWeapons] = new (m_weaponStorage[m_numWeapons]) Weapon(weaponDefinition);
+		++m_numWeapons;
 	}
-	if (!m_weapons.empty())
+	if (m_numWeapons > 0)
 	{
 		EquipWeapon(0);
 	}
@@ -52,7 +54,11 @@ Actor::Actor(Map* map, SpawnInfo const& spawnInfo, ActorHandle handle)
 	// AI Controller
 	if (m_definition->m_ai.m_aiEnabled)
 	{
-		m_aiController = new AI(m_definition->m_ai);
+		m_aiController = m_map->m_actorPool.CreateAI(m_definition);
+		if (!spawnInfo.m_behavior.empty())
+		{
+			m_aiController->SetBehavior(StringToAIBehavior(spawnInfo.m_behavior));
+		}
 
 		m_aiController->Possess(this);
 	}
@@ -86,15 +92,19 @@ Actor::Actor(Map* map, SpawnInfo const& spawnInfo, ActorHandle handle)
 
 Actor::~Actor()
 {
-	delete m_aiController;
-	delete m_animationClock;
+	if (m_aiController != nullptr)
+	{
+		m_map->m_actorPool.DestroyAI(m_aiController, m_definition);
+		m_aiController = nullptr;
+	}
 
-	for (Weapon* weapon : m_weapons)
+	for (int weaponIndex = 0; weaponIndex < m_numWeapons; ++weaponIndex)
 	{
-		weapon->OnUnequip();
-		delete weapon;
+		m_weapons[weaponIndex]->OnUnequip();
+		m_weapons[weaponIndex]->~Weapon();
+		m_weapons[weaponIndex] = nullptr;
 	}
-	m_weapons.clear();
+	m_numWeapons = 0;
 
 	//delete m_vertexBuffer;
 	//m_vertexBuffer = nullptr;
@@ -119,24 +129,20 @@ void Actor::Update(float deltaSeconds)
 	// Update Animation
 	if (m_currentAnimationGroup->m_scaleBySpeed)
 	{
-		m_animationClock->SetTimeScale(m_velocity.GetLength() / m_definition->m_physics.m_runSpeed);
+		m_animationClock.SetTimeScale(GetVelocity().GetLength() / m_definition->m_physics.m_runSpeed);
 	}
 	else
 	{
-		m_animationClock->SetTimeScale(1.0);
+		m_animationClock.SetTimeScale(1.0);
 	}
 
-	if (m_currentAnimationGroup == nullptr || (m_currentAnimationGroup != m_definition->GetDefaultAnimationGroup() && m_currentAnimationGroup->IsAnimationFinished((float)m_animationClock->GetTotalSeconds()) &&  m_currentAnimationGroup->m_name != "Death"))
+	if (m_currentAnimationGroup == nullptr || (m_currentAnimationGroup != m_definition->GetDefaultAnimationGroup() && m_currentAnimationGroup->IsAnimationFinished((float)m_animationClock.GetTotalSeconds()) &&  m_currentAnimationGroup->m_name != "Death"))
 	{
 		// Play Default Animation
 		m_currentAnimationGroup = m_definition->GetDefaultAnimationGroup();
-		m_animationClock->Reset();
+		m_animationClock.Reset();
 	}
 
-	//-----------------------------------------------------------------------------------------------
-	// Update Physics
-	UpdatePhysics(deltaSeconds);
-
 	//-----------------------------------------------------------------------------------------------
 	// Update Audio
 	if (g_theAudio->IsChannelPlaying(m_hurtPlaybackID))
@@ -162,26 +168,6 @@ void Actor::Update(float deltaSeconds)
 
 }
 
-void Actor::UpdatePhysics(float deltaSeconds)
-{
-	if (!m_definition->m_physics.m_simulated || m_isDead)
-	{
-		return;
-	}
-	AddForce(-m_velocity * m_definition->m_physics.m_drag);
-
-	m_velocity += m_acceleration * deltaSeconds;
-	m_position += m_velocity * deltaSeconds;
-	m_acceleration = Vec3::ZERO;
-
-	if (!m_definition->m_physics.m_flying)
-	{
-		m_position.z = 0.f; // force on ground if not flying
-	}
-
-	// TODO gravity?
-}
-
 void Actor::Damage(float damageAmount, Actor* damageCauser)
 {
 	if (m_isDead || m_isGarbage)
@@ -301,6 +287,7 @@ void Actor::Die()
 	}
 
 	m_isDead = true;
+	m_map->m_actorPhysics.ClearFlags(m_handle.GetIndex(), ACTOR_PHYSICS_FLAG_ALIVE);
 	m_corpseTimer = Timer(m_definition->m_corpseLifetime, g_theGame->m_clock);
 	m_corpseTimer.Start();
 	PlayAnimation("Death");
@@ -323,12 +310,12 @@ void Actor::Die()
 
 void Actor::AddForce(Vec3 const& force)
 {
-	m_acceleration += force; // TODO differenet mass?
+	m_map->m_actorPhysics.AddForce(m_handle.GetIndex(), force);
 }
 
 void Actor::AddImpulse(Vec3 const& impulse)
 {
-	m_velocity += impulse;
+	m_map->m_actorPhysics.AddImpulse(m_handle.GetIndex(), impulse);
 }
 
 void Actor::OnCollide(Actor* other)
@@ -349,7 +336,8 @@ void Actor::OnCollide(Actor* other)
 			//}
 		}
 
-		Vec3 impulseDirection = Vec3(m_velocity.x, m_velocity.y, 0.f).GetNormalized();
+		Vec3 velocity = GetVelocity();
+		Vec3 impulseDirection = Vec3(velocity.x, velocity.y, 0.f).GetNormalized();
 		other->AddImpulse(impulseDirection * m_definition->m_collision.m_impulseOnCollide);
 	}
 
@@ -383,7 +371,7 @@ void Actor::TurnInDirection(float targetOrientationDegrees, float maxDeltaDegree
 
 void Actor::Attack()
 {
-	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= (int)m_weapons.size())
+	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= m_numWeapons)
 	{
 		return;
 	}
@@ -392,13 +380,13 @@ void Actor::Attack()
 
 void Actor::EquipWeapon(int weaponIndex)
 {
-	if (weaponIndex < 0 || weaponIndex >= (int)m_weapons.size())
+	if (weaponIndex < 0 || weaponIndex >= m_numWeapons)
 	{
 		return;
 	}
 	if (m_currentWeaponIndex != weaponIndex)
 	{
-		if (m_currentWeaponIndex > 0 && m_currentWeaponIndex <= (int)m_weapons.size())
+		if (m_currentWeaponIndex > 0 && m_currentWeaponIndex <= m_numWeapons)
 		{
 			m_weapons[m_currentWeaponIndex]->OnUnequip();
 		}
@@ -409,27 +397,27 @@ void Actor::EquipWeapon(int weaponIndex)
 
 void Actor::EquipPrevWeapon()
 {
-	if (m_weapons.empty())
+	if (m_numWeapons == 0)
 	{
 		return;
 	}
-	int numWeapon = (int)m_weapons.size();
+	int numWeapon = m_numWeapons;
 	EquipWeapon((m_currentWeaponIndex - 1 + numWeapon) % numWeapon);
 }
 
 void Actor::EquipNextWeapon()
 {
-	if (m_weapons.empty())
+	if (m_numWeapons == 0)
 	{
 		return;
 	}
-	int numWeapon = (int)m_weapons.size();
+	int numWeapon = m_numWeapons;
 	EquipWeapon((m_currentWeaponIndex + 1) % numWeapon);
 }
 
 Weapon* Actor::GetEquippedWeapon() const
 {
-	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= (int)m_weapons.size())
+	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= m_numWeapons)
 	{
 		return nullptr;
 	}
@@ -480,7 +468,7 @@ void Actor::Render() const
 	Vec3 cameraToActor = m_position - currentCamera.GetPosition();
 	Vec3 localViewDirection = GetModelToWorldTransform().GetOrthonormalInverse().TransformVectorQuantity3D(cameraToActor);
 	SpriteAnimDefinition const& animDef = m_currentAnimationGroup->GetAnimationForDirection(localViewDirection);
-	SpriteDefinition const& spriteDef = animDef.GetSpriteDefAtTime((float)m_animationClock->GetTotalSeconds());
+	SpriteDefinition const& spriteDef = animDef.GetSpriteDefAtTime((float)m_animationClock.GetTotalSeconds());
 	AABB2 UVs = spriteDef.GetUVs();
 
 	// Create Geometry
@@ -620,7 +608,7 @@ void Actor::GetThirdPersonCameraPositionAndOrientation(Vec3& camPosition, EulerA
 
 float Actor::GetAttackRange() const
 {
-	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= (int)m_weapons.size())
+	if (m_currentWeaponIndex < 0 || m_currentWeaponIndex >= m_numWeapons)
 	{
 		return 0.f;
 	}
@@ -629,7 +617,7 @@ float Actor::GetAttackRange() const
 
 Vec3 Actor::GetVelocity() const
 {
-	return m_velocity;
+	return m_map->m_actorPhysics.GetVelocity(m_handle.GetIndex());
 }
 
 void Actor::SetInvisible()
@@ -655,7 +643,7 @@ void Actor::PlayAnimation(std::string const& name)
 		if (animGroup != m_currentAnimationGroup)
 		{
 			m_currentAnimationGroup = animGroup;
-			m_animationClock->Reset();
+			m_animationClock.Reset();
 		}
 	}
 }
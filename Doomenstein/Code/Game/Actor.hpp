@@ -3,24 +3,28 @@
 #include "Game/ActorHandle.hpp"
 #include "Game/ActorDefinition.hpp"
 #include "Game/Weapon.hpp"
+#include "Engine/Core/Clock.hpp"
 #include "Engine/Core/Rgba8.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "Engine/Math/Vec3.hpp"
 #include "Engine/Math/EulerAngles.hpp"
 #include <vector>
 
+class AI;
+
 class Actor
 {
 public:
 	Actor() = default;
 	~Actor();
-	Actor(Map* map, SpawnInfo const& spawnInfo, ActorHandle handle);
+	Actor(Map* map, SpawnInfo const& spawnInfo, ActorDefinition const* definition, ActorHandle handle); // built in place by Map::m_actorPool
+	Actor(Actor const& copy) = delete;
 
 	void Update(float deltaSeconds);
 	//void UpdatePhysics(float fixedDeltaSeconds); // after all physics update and endPhysics update, update collision in world?
 	//void EndUpdatePhysics(float fixedDeltaSeconds); // apply acceleration and velocity and clear acceleration
 
-	void UpdatePhysics(float deltaSeconds); // todo make fixed update physics after math assignment
+	// Physics integration runs for all actors at once in Map::UpdateActorPhysics, velocity and acceleration live in Map::m_actorPhysics
 	// consider addForce/moveindirection in update/fixedupdate
 
 
@@ -69,7 +73,7 @@ public:
 	Map*					m_map = nullptr;
 
 
-	Vec3		m_position;
+	Vec3		m_position; // copied from Map::m_actorPhysics after each physics tick, read-only for gameplay
 	EulerAngles m_orientation;
 
 	bool m_isDead		= false;
@@ -77,7 +81,7 @@ public:
 	float m_health		= 77.f;
 
 	Controller* m_controller = nullptr; // currently possessing this actor
-	Controller* m_aiController = nullptr; // if aiEnabled new AI() for it, original ai controller
+	AI* m_aiController = nullptr; // if aiEnabled, original ai controller from Map::m_actorPool
 
 	Rgba8 m_color;
 
@@ -86,11 +90,12 @@ public:
 	bool m_isStaggering = false;
 
 private:
-	Vec3	m_velocity;
-	Vec3	m_acceleration;
 	Timer	m_corpseTimer;
 
-	std::vector<Weapon*> m_weapons;
+	// Weapons are built in place in the inline storage, no heap per weapon
+	alignas(Weapon) unsigned char m_weaponStorage[MAX_ACTOR_WEAPONS][sizeof(Weapon)];
+	Weapon* m_weapons[MAX_ACTOR_WEAPONS] = {};
+	int m_numWeapons = 0;
 	int m_currentWeaponIndex = -1; // if no weapon?
 
 	//std::vector<Vertex_PCU> m_unlitVertexes;
@@ -100,7 +105,7 @@ private:
 
 	// Animation
 	ActorDefinition::AnimationGroup* m_currentAnimationGroup = nullptr;
-	Clock* m_animationClock = nullptr;
+	Clock m_animationClock;
 
 	// Sound
 	SoundPlaybackID m_hurtPlaybackID = MISSING_SOUND_ID;
@@ -1,4 +1,5 @@
 #include "Game/ActorDefinition.hpp"
+#include "Game/WeaponDefinition.hpp"
 #include "Engine/Renderer/Renderer.hpp"
 
 
@@ -42,6 +43,7 @@ bool ActorDefinition::AIInfo::LoadFromXmlElement(XmlElement const& element)
 	m_sightAngle = ParseXmlAttribute(element, "sightAngle", m_sightAngle);
 	m_staggerSeconds = ParseXmlAttribute(element, "staggerSeconds", m_staggerSeconds);
 	m_staggerDamageThreshold = ParseXmlAttribute(element, "staggerDamageThreshold", m_staggerDamageThreshold);
+	m_behavior = StringToAIBehavior(ParseXmlAttribute(element, "behavior", "Coward"));
 	return true;
 }
 
@@ -54,9 +56,11 @@ bool ActorDefinition::InventoryInfo::LoadFromXmlElement(XmlElement const& elemen
 		if (!weaponName.empty())
 		{
 			m_weapons.push_back(weaponName);
+			m_weaponDefinitions.push_back(WeaponDefinition::GetByName(weaponName));
 		}
 		weaponElement = weaponElement->NextSiblingElement("Weapon");
 	}
+	GUARANTEE_OR_DIE((int)m_weapons.size() <= MAX_ACTOR_WEAPONS, Stringf("Inventory has %d weapons, at most %d fit in an actor", (int)m_weapons.size(), MAX_ACTOR_WEAPONS));
 	return true;
 }
 
@@ -86,6 +90,7 @@ STATIC void ActorDefinition::InitializeDefinitions(std::vector<std::string> cons
 
 			ActorDefinition* newActorDef = new ActorDefinition();
 			newActorDef->LoadFromXmlElement(*actorDefElement);
+			newActorDef->m_index = (int)s_definitions.size();
 			s_definitions.push_back(newActorDef);
 
 			actorDefElement = actorDefElement->NextSiblingElement();
@@ -125,6 +130,7 @@ bool ActorDefinition::LoadFromXmlElement(XmlElement const& element)
 	m_faction			= StringToFaction(ParseXmlAttribute(element, "faction", "Neutral"));
 	m_canBePossessed	= ParseXmlAttribute(element, "canBePossessed", m_canBePossessed);
 	m_dieOnSpawn		= ParseXmlAttribute(element, "dieOnSpawn", m_dieOnSpawn);
+	m_poolSize			= ParseXmlAttribute(element, "poolSize", m_poolSize);
 
 	XmlElement const* collisionElement = element.FirstChildElement("Collision");
 	if (collisionElement)
@@ -210,6 +216,18 @@ Faction StringToFaction(std::string const& factionString)
 	}
 }
 
+AIBehavior StringToAIBehavior(std::string const& behaviorString)
+{
+	if (behaviorString == "Melee")
+	{
+		return AIBehavior::MELEE;
+	}
+	else
+	{
+		return AIBehavior::COWARD;
+	}
+}
+
 BillboardType StringToBillboardType(std::string const& billBoardType)
 {
 	if (billBoardType == "WorldUpOpposing")
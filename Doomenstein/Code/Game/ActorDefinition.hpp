@@ -16,8 +16,17 @@ enum class Faction
 	DEMON,
 };
 
+constexpr int MAX_ACTOR_WEAPONS = 4; // actors keep their weapons inline, see Actor::m_weaponStorage
+
+enum class AIBehavior
+{
+	COWARD,	// flees along the map flow field, away from what players can see
+	MELEE,	// chases its target along a shared chase field and attacks in range
+};
+
 
 Faction StringToFaction(std::string const& factionString);
+AIBehavior StringToAIBehavior(std::string const& behaviorString);
 BillboardType StringToBillboardType(std::string const& billBoardType);
 SpriteAnimPlaybackType StringToSpriteAnimPlaybackType(std::string const& playbackType);
 
@@ -77,6 +86,7 @@ struct ActorDefinition
 		float	m_sightAngle = 0.f;
 		float	m_staggerSeconds = 0.f;
 		float	m_staggerDamageThreshold = 1000.f;
+		AIBehavior m_behavior = AIBehavior::COWARD;
 
 		bool LoadFromXmlElement(XmlElement const& element);
 	};
@@ -84,6 +94,7 @@ struct ActorDefinition
 	struct InventoryInfo
 	{
 		std::vector<std::string> m_weapons;
+		std::vector<WeaponDefinition const*> m_weaponDefinitions; // same order as m_weapons, at most MAX_ACTOR_WEAPONS
 
 		bool LoadFromXmlElement(XmlElement const& element);
 	};
@@ -131,6 +142,8 @@ struct ActorDefinition
 	AnimationGroup* GetDefaultAnimationGroup() const;
 
 	std::string m_name = "UNKNOWNACTOR";
+	int			m_index = -1; // in s_definitions
+	int			m_poolSize = 0; // actors reserved in every map's ActorPool
 	bool		m_isVisible = false;
 	float		m_health = 1.f;
 	float		m_corpseLifetime = 0.f;
@@ -1,11 +1,11 @@
 #include "Game/ActorHandle.hpp"
 
-const ActorHandle ActorHandle::INVALID = ActorHandle(0x0000FFFFu, 0x0000FFFFu);
+const ActorHandle ActorHandle::INVALID = ActorHandle(0xFFFFFFFFu, 0xFFFFFFFFu);
 
 
-ActorHandle::ActorHandle(unsigned int uid, unsigned int index)
+ActorHandle::ActorHandle(unsigned int generation, unsigned int index)
 {
-	m_data = (uid << 16) | (0x0000FFFFu & index);
+	m_data = (static_cast<uint64_t>(generation) << 32) | index;
 }
 
 bool ActorHandle::IsValid() const
@@ -15,7 +15,12 @@ bool ActorHandle::IsValid() const
 
 unsigned int ActorHandle::GetIndex() const
 {
-	return m_data & 0x0000FFFFu;
+	return static_cast<unsigned int>(m_data & 0xFFFFFFFFu);
+}
+
+unsigned int ActorHandle::GetGeneration() const
+{
+	return static_cast<unsigned int>(m_data >> 32);
 }
 
 bool ActorHandle::operator==(const ActorHandle& other) const
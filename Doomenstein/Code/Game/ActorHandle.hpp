@@ -1,21 +1,26 @@
 #pragma once
+#include <stdint.h>
 
+//-----------------------------------------------------------------------------------------------
+// Slot index in the low 32 bits, the slot's generation in the high 32 bits. Map bumps a slot's
+// generation when its actor is deleted, so handles to the old actor stop resolving once the
+// slot is reused.
+//
 struct ActorHandle
 {
 public:
 	ActorHandle() = default;
-	ActorHandle(unsigned int uid, unsigned int index);
+	ActorHandle(unsigned int generation, unsigned int index);
 
 	bool IsValid() const;
 	unsigned int GetIndex() const;
+	unsigned int GetGeneration() const;
 	bool operator==(const ActorHandle& other) const;
 	bool operator!=(const ActorHandle& other) const;
 
 	static const ActorHandle INVALID;
-	static const unsigned int MAX_ACTOR_UID = 0x0000FFFEu;
-	static const unsigned int MAX_ACTOR_INDEX = 0x0000FFFFu;
+	static const unsigned int MAX_ACTOR_INDEX = 0x7FFFFFFFu;
 
 private:
-	unsigned int m_data = 0xFFFFFFFFu;
+	uint64_t m_data = 0xFFFFFFFFFFFFFFFFull;
 };
-
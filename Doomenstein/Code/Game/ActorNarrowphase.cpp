@@ -0,0 +1,342 @@
+#include "Game/ActorNarrowphase.hpp"
+#include "Game/ActorPhysicsStore.hpp"
+#include "Game/WorkerPool.hpp"
+#include <math.h>
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------------------------
+enum SimulatedCombination
+{
+	SIMULATED_BOTH,
+	SIMULATED_A_ONLY,
+	SIMULATED_B_ONLY,
+	NUM_COMBINATIONS
+};
+
+//-----------------------------------------------------------------------------------------------
+// Pushes up to 4 pairs that share no actor. Matches PushDiscsOutOfEachOther2D / PushDiscOutOfFixedDisc2D:
+// nothing happens unless the z ranges overlap and the discs overlap by more than 0, the push direction
+// is the normalized center displacement (zero when the centers coincide), and two simulated discs split
+// the overlap evenly.
+//
+template <bool IS_SIMULATED_A, bool IS_SIMULATED_B>
+static void PushPairs4(ActorPhysicsStore& physics, ActorPair const* pairs, int const* pairIndexes, int count, unsigned char* out_isPushed)
+{
+	int slotsA[4];
+	int slotsB[4];
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		ActorPair const& pair = pairs[pairIndexes[(lane < count) ? lane : 0]];
+		slotsA[lane] = pair.m_actorIndexA;
+		slotsB[lane] = pair.m_actorIndexB;
+	}
+
+	float const* posX = physics.m_positionX.data();
+	float const* posY = physics.m_positionY.data();
+	float const* posZ = physics.m_positionZ.data();
+	float const* radius = physics.m_radius.data();
+	float const* height = physics.m_height.data();
+
+	__m128 centerAX = _mm_setr_ps(posX[slotsA[0]], posX[slotsA[1]], posX[slotsA[2]], posX[slotsA[3]]);
+	__m128 centerAY = _mm_setr_ps(posY[slotsA[0]], posY[slotsA[1]], posY[slotsA[2]], posY[slotsA[3]]);
+	__m128 centerBX = _mm_setr_ps(posX[slotsB[0]], posX[slotsB[1]], posX[slotsB[2]], posX[slotsB[3]]);
+	__m128 centerBY = _mm_setr_ps(posY[slotsB[0]], posY[slotsB[1]], posY[slotsB[2]], posY[slotsB[3]]);
+	__m128 minZA = _mm_setr_ps(posZ[slotsA[0]], posZ[slotsA[1]], posZ[slotsA[2]], posZ[slotsA[3]]);
+	__m128 minZB = _mm_setr_ps(posZ[slotsB[0]], posZ[slotsB[1]], posZ[slotsB[2]], posZ[slotsB[3]]);
+	__m128 maxZA = _mm_add_ps(minZA, _mm_setr_ps(height[slotsA[0]], height[slotsA[1]], height[slotsA[2]], height[slotsA[3]]));
+	__m128 maxZB = _mm_add_ps(minZB, _mm_setr_ps(height[slotsB[0]], height[slotsB[1]], height[slotsB[2]], height[slotsB[3]]));
+	__m128 radiusA = _mm_setr_ps(radius[slotsA[0]], radius[slotsA[1]], radius[slotsA[2]], radius[slotsA[3]]);
+	__m128 radiusB = _mm_setr_ps(radius[slotsB[0]], radius[slotsB[1]], radius[slotsB[2]], radius[slotsB[3]]);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 isZOverlapping = _mm_and_ps(_mm_cmple_ps(minZA, maxZB), _mm_cmple_ps(minZB, maxZA));
+
+	// Displacement points from the disc that stays (or A) towards the disc that moves (or B)
+	__m128 displacementX = (IS_SIMULATED_A && !IS_SIMULATED_B) ? _mm_sub_ps(centerAX, centerBX) : _mm_sub_ps(centerBX, centerAX);
+	__m128 displacementY = (IS_SIMULATED_A && !IS_SIMULATED_B) ? _mm_sub_ps(centerAY, centerBY) : _mm_sub_ps(centerBY, centerAY);
+	__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(displacementX, displacementX), _mm_mul_ps(displacementY, displacementY)));
+	__m128 overlap = _mm_sub_ps(_mm_add_ps(radiusA, radiusB), distance);
+	__m128 isPushed = _mm_and_ps(isZOverlapping, _mm_cmpgt_ps(overlap, zero));
+
+	int pushedLanes = _mm_movemask_ps(isPushed) & ((1 << count) - 1);
+	for (int lane = 0; lane < count; ++lane)
+	{
+		out_isPushed[pairIndexes[lane]] = (unsigned char)((pushedLanes >> lane) & 1);
+	}
+	if (pushedLanes == 0)
+	{
+		return;
+	}
+
+	__m128 hasLength = _mm_cmpgt_ps(distance, zero);
+	__m128 inverseDistance = _mm_and_ps(hasLength, _mm_div_ps(_mm_set1_ps(1.f), distance));
+	__m128 directionX = _mm_mul_ps(displacementX, inverseDistance);
+	__m128 directionY = _mm_mul_ps(displacementY, inverseDistance);
+
+	__m128 pushAmount = (IS_SIMULATED_A && IS_SIMULATED_B) ? _mm_mul_ps(overlap, _mm_set1_ps(0.5f)) : overlap;
+	__m128 pushX = _mm_and_ps(isPushed, _mm_mul_ps(directionX, pushAmount));
+	__m128 pushY = _mm_and_ps(isPushed, _mm_mul_ps(directionY, pushAmount));
+
+	alignas(16) float newAX[4];
+	alignas(16) float newAY[4];
+	alignas(16) float newBX[4];
+	alignas(16) float newBY[4];
+	if (IS_SIMULATED_A)
+	{
+		_mm_store_ps(newAX, IS_SIMULATED_B ? _mm_sub_ps(centerAX, pushX) : _mm_add_ps(centerAX, pushX));
+		_mm_store_ps(newAY, IS_SIMULATED_B ? _mm_sub_ps(centerAY, pushY) : _mm_add_ps(centerAY, pushY));
+	}
+	if (IS_SIMULATED_B)
+	{
+		_mm_store_ps(newBX, _mm_add_ps(centerBX, pushX));
+		_mm_store_ps(newBY, _mm_add_ps(centerBY, pushY));
+	}
+
+	for (int lane = 0; lane < count; ++lane)
+	{
+		if (((pushedLanes >> lane) & 1) == 0)
+		{
+			continue;
+		}
+		if (IS_SIMULATED_A)
+		{
+			physics.m_positionX[slotsA[lane]] = newAX[lane];
+			physics.m_positionY[slotsA[lane]] = newAY[lane];
+		}
+		if (IS_SIMULATED_B)
+		{
+			physics.m_positionX[slotsB[lane]] = newBX[lane];
+			physics.m_positionY[slotsB[lane]] = newBY[lane];
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+void ActorNarrowphase::PushPairs(ActorPhysicsStore& physics, ActorPair const* pairs, int numPairs, std::vector<unsigned char>& out_isPushed)
+{
+	out_isPushed.assign(numPairs, 0);
+	if (numPairs == 0)
+	{
+		return;
+	}
+
+	// Level of a pair is one past the last level either of its actors was used in, so pairs touching
+	// the same actor keep their list order and pairs in one level never touch the same actor
+	if ((int)m_slotLevels.size() < physics.GetNumSlots())
+	{
+		m_slotLevels.resize(physics.GetNumSlots(), -1);
+	}
+	m_pairBuckets.resize(numPairs);
+	int numLevels = 0;
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		int slotA = pairs[pairIndex].m_actorIndexA;
+		int slotB = pairs[pairIndex].m_actorIndexB;
+		bool isSimulatedA = physics.HasFlags(slotA, ACTOR_PHYSICS_FLAG_SIMULATED);
+		bool isSimulatedB = physics.HasFlags(slotB, ACTOR_PHYSICS_FLAG_SIMULATED);
+		if (!isSimulatedA && !isSimulatedB)
+		{
+			m_pairBuckets[pairIndex] = -1;
+			continue;
+		}
+
+		int level = ((m_slotLevels[slotA] > m_slotLevels[slotB]) ? m_slotLevels[slotA] : m_slotLevels[slotB]) + 1;
+		m_slotLevels[slotA] = level;
+		m_slotLevels[slotB] = level;
+		numLevels = (level + 1 > numLevels) ? level + 1 : numLevels;
+
+		int combination = (isSimulatedA && isSimulatedB) ? SIMULATED_BOTH : (isSimulatedA ? SIMULATED_A_ONLY : SIMULATED_B_ONLY);
+		m_pairBuckets[pairIndex] = level * NUM_COMBINATIONS + combination;
+	}
+
+	// Counting sort pair indexes by bucket, and reset the slot levels for the next batch
+	int numBuckets = numLevels * NUM_COMBINATIONS;
+	m_bucketStarts.assign(numBuckets + 1, 0);
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		m_slotLevels[pairs[pairIndex].m_actorIndexA] = -1;
+		m_slotLevels[pairs[pairIndex].m_actorIndexB] = -1;
+		if (m_pairBuckets[pairIndex] >= 0)
+		{
+			m_bucketStarts[m_pairBuckets[pairIndex] + 1]++;
+		}
+	}
+	for (int bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		m_bucketStarts[bucket + 1] += m_bucketStarts[bucket];
+	}
+	m_sortedPairs.resize(m_bucketStarts[numBuckets]);
+	m_bucketCursors.assign(m_bucketStarts.begin(), m_bucketStarts.end() - 1);
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		if (m_pairBuckets[pairIndex] >= 0)
+		{
+			m_sortedPairs[m_bucketCursors[m_pairBuckets[pairIndex]]++] = pairIndex;
+		}
+	}
+
+	// Levels must run in order, the buckets inside a level are independent of each other
+	for (int bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		int bucketEnd = m_bucketStarts[bucket + 1];
+		for (int sortedIndex = m_bucketStarts[bucket]; sortedIndex < bucketEnd; sortedIndex += 4)
+		{
+			int count = (bucketEnd - sortedIndex < 4) ? bucketEnd - sortedIndex : 4;
+			int const* pairIndexes = &m_sortedPairs[sortedIndex];
+			switch (bucket % NUM_COMBINATIONS)
+			{
+			case SIMULATED_BOTH:	PushPairs4<true, true>(physics, pairs, pairIndexes, count, out_isPushed.data());	break;
+			case SIMULATED_A_ONLY:	PushPairs4<true, false>(physics, pairs, pairIndexes, count, out_isPushed.data());	break;
+			case SIMULATED_B_ONLY:	PushPairs4<false, true>(physics, pairs, pairIndexes, count, out_isPushed.data());	break;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+// Scalar version of one lane of PushPairs4, returning the displacement for one side of the pair
+// instead of moving it. Returns false if the pair does not overlap.
+//
+static bool GetPushForSlot(ActorPhysicsStore const& physics, ActorPair const& pair, int slot, float& out_pushX, float& out_pushY)
+{
+	int slotA = pair.m_actorIndexA;
+	int slotB = pair.m_actorIndexB;
+	out_pushX = 0.f;
+	out_pushY = 0.f;
+
+	float minZA = physics.m_positionZ[slotA];
+	float minZB = physics.m_positionZ[slotB];
+	if (!(minZA <= minZB + physics.m_height[slotB] && minZB <= minZA + physics.m_height[slotA]))
+	{
+		return false;
+	}
+
+	float displacementX = physics.m_positionX[slotB] - physics.m_positionX[slotA];
+	float displacementY = physics.m_positionY[slotB] - physics.m_positionY[slotA];
+	float distance = sqrtf(displacementX * displacementX + displacementY * displacementY);
+	float overlap = physics.m_radius[slotA] + physics.m_radius[slotB] - distance;
+	if (!(overlap > 0.f))
+	{
+		return false;
+	}
+
+	bool isSimulatedA = physics.HasFlags(slotA, ACTOR_PHYSICS_FLAG_SIMULATED);
+	bool isSimulatedB = physics.HasFlags(slotB, ACTOR_PHYSICS_FLAG_SIMULATED);
+	bool isSelfA = (slot == slotA);
+	if ((isSelfA && !isSimulatedA) || (!isSelfA && !isSimulatedB))
+	{
+		return true;
+	}
+
+	float inverseDistance = (distance > 0.f) ? 1.f / distance : 0.f;
+	float pushAmount = (isSimulatedA && isSimulatedB) ? overlap * 0.5f : overlap;
+	float sign = isSelfA ? -1.f : 1.f;
+	out_pushX = sign * displacementX * inverseDistance * pushAmount;
+	out_pushY = sign * displacementY * inverseDistance * pushAmount;
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------
+void ActorNarrowphase::ResolvePairsJacobi(ActorPhysicsStore& physics, ActorPair const* pairs, int numPairs, int numIterations, WorkerPool* workerPool, std::vector<unsigned char>& out_isPushed)
+{
+	out_isPushed.assign(numPairs, 0);
+	if (numPairs == 0)
+	{
+		return;
+	}
+
+	// Build the per-actor pair lists, each in pair order
+	if ((int)m_slotToActorIndex.size() < physics.GetNumSlots())
+	{
+		m_slotToActorIndex.resize(physics.GetNumSlots(), -1);
+	}
+	m_actorSlots.clear();
+	m_actorPairStarts.clear();
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		int slots[2] = { pairs[pairIndex].m_actorIndexA, pairs[pairIndex].m_actorIndexB };
+		for (int slot : slots)
+		{
+			if (m_slotToActorIndex[slot] < 0)
+			{
+				m_slotToActorIndex[slot] = (int)m_actorSlots.size();
+				m_actorSlots.push_back(slot);
+				m_actorPairStarts.push_back(0);
+			}
+			m_actorPairStarts[m_slotToActorIndex[slot]]++;
+		}
+	}
+	int numActors = (int)m_actorSlots.size();
+	m_actorPairStarts.push_back(0);
+	int runningTotal = 0;
+	for (int actorIndex = 0; actorIndex <= numActors; ++actorIndex)
+	{
+		int numActorPairs = m_actorPairStarts[actorIndex];
+		m_actorPairStarts[actorIndex] = runningTotal;
+		runningTotal += numActorPairs;
+	}
+	m_actorPairIndexes.resize(runningTotal);
+	m_displacementX.assign(numActors, 0.f);
+	m_displacementY.assign(numActors, 0.f);
+	m_actorPairCursors.assign(m_actorPairStarts.begin(), m_actorPairStarts.end() - 1);
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		m_actorPairIndexes[m_actorPairCursors[m_slotToActorIndex[pairs[pairIndex].m_actorIndexA]]++] = pairIndex;
+		m_actorPairIndexes[m_actorPairCursors[m_slotToActorIndex[pairs[pairIndex].m_actorIndexB]]++] = pairIndex;
+	}
+	for (int slot : m_actorSlots)
+	{
+		m_slotToActorIndex[slot] = -1;
+	}
+
+	int const batchSize = 64;
+	std::function<void(int, int)> accumulatePushes = [&](int begin, int end)
+		{
+			for (int actorIndex = begin; actorIndex < end; ++actorIndex)
+			{
+				int slot = m_actorSlots[actorIndex];
+				float sumX = 0.f;
+				float sumY = 0.f;
+				for (int listIndex = m_actorPairStarts[actorIndex]; listIndex < m_actorPairStarts[actorIndex + 1]; ++listIndex)
+				{
+					int pairIndex = m_actorPairIndexes[listIndex];
+					float pushX;
+					float pushY;
+					if (GetPushForSlot(physics, pairs[pairIndex], slot, pushX, pushY))
+					{
+						sumX += pushX;
+						sumY += pushY;
+						if (slot == pairs[pairIndex].m_actorIndexA)
+						{
+							out_isPushed[pairIndex] = 1; // only A's side writes the flag
+						}
+					}
+				}
+				m_displacementX[actorIndex] = sumX;
+				m_displacementY[actorIndex] = sumY;
+			}
+		};
+	std::function<void(int, int)> applyPushes = [&](int begin, int end)
+		{
+			for (int actorIndex = begin; actorIndex < end; ++actorIndex)
+			{
+				int slot = m_actorSlots[actorIndex];
+				physics.m_positionX[slot] += m_displacementX[actorIndex];
+				physics.m_positionY[slot] += m_displacementY[actorIndex];
+			}
+		};
+
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		if (workerPool != nullptr)
+		{
+			workerPool->ParallelFor(numActors, batchSize, accumulatePushes);
+			workerPool->ParallelFor(numActors, batchSize, applyPushes);
+		}
+		else
+		{
+			accumulatePushes(0, numActors);
+			applyPushes(0, numActors);
+		}
+	}
+}
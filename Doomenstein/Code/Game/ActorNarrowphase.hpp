@@ -0,0 +1,42 @@
+#pragma once
+#include "Game/ActorSpatialGrid.hpp"
+#include <vector>
+
+class ActorPhysicsStore;
+class WorkerPool;
+
+//-----------------------------------------------------------------------------------------------
+// Batched disc-vs-disc push for a list of actor pairs. The list is split into levels in which no
+// two pairs share an actor, so a level can be pushed 4 pairs at a time with SSE and still end with
+// the same positions as walking the list one pair at a time. Inside a level the pairs are bucketed
+// by which side is simulated, and each bucket runs a kernel specialized for that combination.
+// Filtering (alive, owner, collidesWithActors) and OnCollide are left to the caller.
+//
+// ResolvePairsJacobi is the order-independent alternative: every actor sums the pushes from all of
+// its pairs against the same snapshot of positions, then all sums are applied at once, repeated for
+// a number of relaxation iterations. Each actor adds its pairs up in pair order no matter which
+// thread runs it, so the result does not depend on the number of threads.
+//
+class ActorNarrowphase
+{
+public:
+	void PushPairs(ActorPhysicsStore& physics, ActorPair const* pairs, int numPairs, std::vector<unsigned char>& out_isPushed);
+	void ResolvePairsJacobi(ActorPhysicsStore& physics, ActorPair const* pairs, int numPairs, int numIterations, WorkerPool* workerPool, std::vector<unsigned char>& out_isPushed);
+
+private:
+	std::vector<int>	m_slotLevels;	// last level each actor slot was used in, -1 if unused in this batch
+	std::vector<int>	m_pairBuckets;	// level * NUM_COMBINATIONS + combination, -1 if nothing can move
+	std::vector<int>	m_bucketStarts;
+	std::vector<int>	m_bucketCursors;
+	std::vector<int>	m_sortedPairs;
+
+	// Jacobi: pairs of each actor in CSR form
+	std::vector<int>	m_actorSlots;			// actors that are in at least one pair
+	std::vector<int>	m_actorPairStarts;		// m_actorSlots.size() + 1 offsets into m_actorPairIndexes
+	std::vector<int>	m_actorPairIndexes;
+	std::vector<int>	m_actorPairCursors;
+	std::vector<int>	m_slotToActorIndex;		// actor slot -> index into m_actorSlots, -1 if not in any pair
+	std::vector<float>	m_displacementX;
+	std::vector<float>	m_displacementY;
+};
+
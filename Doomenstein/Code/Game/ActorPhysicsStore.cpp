@@ -0,0 +1,147 @@
+#include "Game/ActorPhysicsStore.hpp"
+#include "Game/ActorDefinition.hpp"
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------------------------
+void ActorPhysicsStore::AddActor(int slot, ActorDefinition const* definition, Vec3 const& position, Vec3 const& velocity)
+{
+	EnsureCapacity(slot + 1);
+
+	m_positionX[slot] = position.x;
+	m_positionY[slot] = position.y;
+	m_positionZ[slot] = position.z;
+	m_velocityX[slot] = velocity.x;
+	m_velocityY[slot] = velocity.y;
+	m_velocityZ[slot] = velocity.z;
+	m_accelerationX[slot] = 0.f;
+	m_accelerationY[slot] = 0.f;
+	m_accelerationZ[slot] = 0.f;
+	m_radius[slot] = definition->m_collision.m_physicsRadius;
+	m_height[slot] = definition->m_collision.m_physicsHeight;
+	m_drag[slot] = definition->m_physics.m_drag;
+
+	unsigned char flags = ACTOR_PHYSICS_FLAG_ACTIVE | ACTOR_PHYSICS_FLAG_ALIVE;
+	if (definition->m_physics.m_simulated)				flags |= ACTOR_PHYSICS_FLAG_SIMULATED;
+	if (definition->m_physics.m_flying)					flags |= ACTOR_PHYSICS_FLAG_FLYING;
+	if (definition->m_collision.m_collidesWithActors)	flags |= ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS;
+	if (definition->m_collision.m_collidesWithWorld)	flags |= ACTOR_PHYSICS_FLAG_COLLIDES_WITH_WORLD;
+	if (definition->m_collision.m_dieOnCollide || definition->m_collision.m_damageOnCollide != FloatRange::ZERO)
+	{
+		flags |= ACTOR_PHYSICS_FLAG_LETHAL_ON_COLLIDE;
+	}
+	m_flags[slot] = flags;
+}
+
+void ActorPhysicsStore::RemoveActor(int slot)
+{
+	m_flags[slot] = ACTOR_PHYSICS_FLAG_NONE;
+}
+
+//-----------------------------------------------------------------------------------------------
+// Same math as the old Actor::UpdatePhysics, 4 slots at a time:
+//   acc += -vel * drag;  vel += acc * dt;  pos += vel * dt;  acc = 0;  if (!flying) pos.z = 0;
+// Slots that are not simulated, dead or empty keep all their values.
+//
+void ActorPhysicsStore::Integrate(float deltaSeconds)
+{
+	__m128 const dt = _mm_set1_ps(deltaSeconds);
+	__m128i const simulatedBits = _mm_set1_epi32(ACTOR_PHYSICS_FLAG_ACTIVE | ACTOR_PHYSICS_FLAG_ALIVE | ACTOR_PHYSICS_FLAG_SIMULATED);
+	__m128i const flyingBit = _mm_set1_epi32(ACTOR_PHYSICS_FLAG_FLYING);
+
+	for (int slot = 0; slot < m_numSlots; slot += 4)
+	{
+		__m128i flags = _mm_set_epi32(m_flags[slot + 3], m_flags[slot + 2], m_flags[slot + 1], m_flags[slot]);
+		__m128 simulatedMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, simulatedBits), simulatedBits));
+		if (_mm_movemask_ps(simulatedMask) == 0)
+		{
+			continue;
+		}
+		__m128 groundedMask = _mm_and_ps(simulatedMask, _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, flyingBit), _mm_setzero_si128())));
+
+		__m128 drag = _mm_loadu_ps(&m_drag[slot]);
+
+		float* positions[3]		= { &m_positionX[slot], &m_positionY[slot], &m_positionZ[slot] };
+		float* velocities[3]	= { &m_velocityX[slot], &m_velocityY[slot], &m_velocityZ[slot] };
+		float* accelerations[3]	= { &m_accelerationX[slot], &m_accelerationY[slot], &m_accelerationZ[slot] };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			__m128 pos = _mm_loadu_ps(positions[axis]);
+			__m128 vel = _mm_loadu_ps(velocities[axis]);
+			__m128 acc = _mm_loadu_ps(accelerations[axis]);
+
+			__m128 newAcc = _mm_sub_ps(acc, _mm_mul_ps(vel, drag));
+			__m128 newVel = _mm_add_ps(vel, _mm_mul_ps(newAcc, dt));
+			__m128 newPos = _mm_add_ps(pos, _mm_mul_ps(newVel, dt));
+			if (axis == 2)
+			{
+				newPos = _mm_andnot_ps(groundedMask, newPos); // force on ground if not flying
+			}
+
+			_mm_storeu_ps(positions[axis], _mm_or_ps(_mm_and_ps(simulatedMask, newPos), _mm_andnot_ps(simulatedMask, pos)));
+			_mm_storeu_ps(velocities[axis], _mm_or_ps(_mm_and_ps(simulatedMask, newVel), _mm_andnot_ps(simulatedMask, vel)));
+			_mm_storeu_ps(accelerations[axis], _mm_andnot_ps(simulatedMask, acc));
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+Vec3 ActorPhysicsStore::GetPosition(int slot) const
+{
+	return Vec3(m_positionX[slot], m_positionY[slot], m_positionZ[slot]);
+}
+
+void ActorPhysicsStore::SetPosition(int slot, Vec3 const& position)
+{
+	m_positionX[slot] = position.x;
+	m_positionY[slot] = position.y;
+	m_positionZ[slot] = position.z;
+}
+
+Vec3 ActorPhysicsStore::GetVelocity(int slot) const
+{
+	return Vec3(m_velocityX[slot], m_velocityY[slot], m_velocityZ[slot]);
+}
+
+void ActorPhysicsStore::AddForce(int slot, Vec3 const& force)
+{
+	// Every actor has a mass of 1, so a force is an acceleration and an impulse is a velocity change
+	m_accelerationX[slot] += force.x;
+	m_accelerationY[slot] += force.y;
+	m_accelerationZ[slot] += force.z;
+}
+
+void ActorPhysicsStore::AddImpulse(int slot, Vec3 const& impulse)
+{
+	m_velocityX[slot] += impulse.x;
+	m_velocityY[slot] += impulse.y;
+	m_velocityZ[slot] += impulse.z;
+}
+
+//-----------------------------------------------------------------------------------------------
+void ActorPhysicsStore::EnsureCapacity(int numSlots)
+{
+	if (numSlots > m_numSlots)
+	{
+		m_numSlots = numSlots;
+	}
+	int paddedSize = (m_numSlots + 3) & ~3;
+	if ((int)m_flags.size() >= paddedSize)
+	{
+		return;
+	}
+
+	m_positionX.resize(paddedSize, 0.f);
+	m_positionY.resize(paddedSize, 0.f);
+	m_positionZ.resize(paddedSize, 0.f);
+	m_velocityX.resize(paddedSize, 0.f);
+	m_velocityY.resize(paddedSize, 0.f);
+	m_velocityZ.resize(paddedSize, 0.f);
+	m_accelerationX.resize(paddedSize, 0.f);
+	m_accelerationY.resize(paddedSize, 0.f);
+	m_accelerationZ.resize(paddedSize, 0.f);
+	m_radius.resize(paddedSize, 0.f);
+	m_height.resize(paddedSize, 0.f);
+	m_drag.resize(paddedSize, 0.f);
+	m_flags.resize(paddedSize, (unsigned char)ACTOR_PHYSICS_FLAG_NONE);
+}
+
@@ -0,0 +1,66 @@
+#pragma once
+#include "Engine/Math/Vec3.hpp"
+#include <vector>
+
+struct ActorDefinition;
+
+//-----------------------------------------------------------------------------------------------
+enum ActorPhysicsFlags : unsigned char
+{
+	ACTOR_PHYSICS_FLAG_NONE					= 0,
+	ACTOR_PHYSICS_FLAG_ACTIVE				= 1 << 0, // slot holds an actor
+	ACTOR_PHYSICS_FLAG_ALIVE				= 1 << 1,
+	ACTOR_PHYSICS_FLAG_SIMULATED			= 1 << 2,
+	ACTOR_PHYSICS_FLAG_FLYING				= 1 << 3,
+	ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS	= 1 << 4,
+	ACTOR_PHYSICS_FLAG_COLLIDES_WITH_WORLD	= 1 << 5,
+	ACTOR_PHYSICS_FLAG_LETHAL_ON_COLLIDE	= 1 << 6, // dies or deals damage in OnCollide, so collisions can change who is alive
+};
+
+//-----------------------------------------------------------------------------------------------
+// Structure-of-arrays copy of the per-actor data the physics loops need, indexed by actor slot
+// (ActorHandle::GetIndex()). Position, velocity and acceleration live here; Actor::m_position is
+// written back by Map once the physics phase of the tick is done.
+// Arrays are padded to a multiple of 4 so the integrator can always run full SSE lanes.
+//
+class ActorPhysicsStore
+{
+public:
+	void AddActor(int slot, ActorDefinition const* definition, Vec3 const& position, Vec3 const& velocity);
+	void RemoveActor(int slot);
+
+	void Integrate(float deltaSeconds);
+
+	int GetNumSlots() const { return m_numSlots; }
+	bool HasFlags(int slot, unsigned char flags) const { return (m_flags[slot] & flags) == flags; }
+	void SetFlags(int slot, unsigned char flags) { m_flags[slot] |= flags; }
+	void ClearFlags(int slot, unsigned char flags) { m_flags[slot] &= ~flags; }
+
+	Vec3 GetPosition(int slot) const;
+	void SetPosition(int slot, Vec3 const& position);
+	Vec3 GetVelocity(int slot) const;
+	void AddForce(int slot, Vec3 const& force); // unit mass
+	void AddImpulse(int slot, Vec3 const& impulse);
+
+private:
+	void EnsureCapacity(int numSlots);
+
+public:
+	std::vector<float>			m_positionX;
+	std::vector<float>			m_positionY;
+	std::vector<float>			m_positionZ;
+	std::vector<float>			m_velocityX;
+	std::vector<float>			m_velocityY;
+	std::vector<float>			m_velocityZ;
+	std::vector<float>			m_accelerationX;
+	std::vector<float>			m_accelerationY;
+	std::vector<float>			m_accelerationZ;
+	std::vector<float>			m_radius;
+	std::vector<float>			m_height;
+	std::vector<float>			m_drag;
+	std::vector<unsigned char>	m_flags;
+
+private:
+	int m_numSlots = 0; // highest used slot + 1, the arrays themselves are padded past this
+};
+
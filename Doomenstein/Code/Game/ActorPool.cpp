@@ -0,0 +1,129 @@
+#include "Game/ActorPool.hpp"
+#include "Game/Actor.hpp"
+#include "Game/AI.hpp"
+#include "Game/ActorDefinition.hpp"
+#include <cstddef>
+#include <new>
+
+//-----------------------------------------------------------------------------------------------
+constexpr int MIN_CHUNK_OBJECTS = 4; // chunk size for definitions without a poolSize
+
+static_assert(alignof(Actor) <= alignof(std::max_align_t), "Actor is over-aligned for the pool chunks");
+static_assert(alignof(AI) <= alignof(std::max_align_t), "AI is over-aligned for the pool chunks");
+
+//-----------------------------------------------------------------------------------------------
+ActorPool::~ActorPool()
+{
+	GUARANTEE_OR_DIE(m_numLiveActors == 0, "Actor pool destroyed with live actors");
+
+	for (unsigned char* chunk : m_chunks)
+	{
+		delete[] chunk;
+	}
+	m_chunks.clear();
+}
+
+void ActorPool::ReserveFromDefinitions()
+{
+	for (ActorDefinition const* definition : ActorDefinition::s_definitions)
+	{
+		if (definition->m_poolSize <= 0)
+		{
+			continue;
+		}
+
+		DefinitionPool& pool = GetDefinitionPool(definition);
+		if (pool.m_numActors < definition->m_poolSize)
+		{
+			m_numPooledActors += definition->m_poolSize - pool.m_numActors;
+			AddChunk(pool.m_freeActors, pool.m_numActors, sizeof(Actor), definition->m_poolSize - pool.m_numActors);
+		}
+		if (definition->m_ai.m_aiEnabled && pool.m_numAIs < definition->m_poolSize)
+		{
+			AddChunk(pool.m_freeAIs, pool.m_numAIs, sizeof(AI), definition->m_poolSize - pool.m_numAIs);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+Actor* ActorPool::CreateActor(Map* map, SpawnInfo const& spawnInfo, ActorDefinition const* definition, ActorHandle handle)
+{
+	DefinitionPool& pool = GetDefinitionPool(definition);
+	if (pool.m_freeActors.empty())
+	{
+		int numNewActors = (definition->m_poolSize > 0) ? definition->m_poolSize : MIN_CHUNK_OBJECTS;
+		AddChunk(pool.m_freeActors, pool.m_numActors, sizeof(Actor), numNewActors);
+		m_numPooledActors += numNewActors;
+	}
+
+	void* memory = pool.m_freeActors.back();
+	pool.m_freeActors.pop_back();
+	++m_numLiveActors;
+	return new (memory) Actor(map, spawnInfo, definition, handle);
+}
+
+void ActorPool::DestroyActor(Actor* actor)
+{
+	if (actor == nullptr)
+	{
+		return;
+	}
+
+	DefinitionPool& pool = GetDefinitionPool(actor->m_definition);
+	actor->~Actor();
+	pool.m_freeActors.push_back(actor);
+	--m_numLiveActors;
+}
+
+AI* ActorPool::CreateAI(ActorDefinition const* definition)
+{
+	DefinitionPool& pool = GetDefinitionPool(definition);
+	if (pool.m_freeAIs.empty())
+	{
+		int numNewAIs = (definition->m_poolSize > 0) ? definition->m_poolSize : MIN_CHUNK_OBJECTS;
+		AddChunk(pool.m_freeAIs, pool.m_numAIs, sizeof(AI), numNewAIs);
+	}
+
+	void* memory = pool.m_freeAIs.back();
+	pool.m_freeAIs.pop_back();
+	return new (memory) AI(definition->m_ai);
+}
+
+void ActorPool::DestroyAI(AI* ai, ActorDefinition const* definition)
+{
+	if (ai == nullptr)
+	{
+		return;
+	}
+
+	DefinitionPool& pool = GetDefinitionPool(definition);
+	ai->~AI();
+	pool.m_freeAIs.push_back(ai);
+}
+
+//-----------------------------------------------------------------------------------------------
+ActorPool::DefinitionPool& ActorPool::GetDefinitionPool(ActorDefinition const* definition)
+{
+	if (definition->m_index >= (int)m_definitionPools.size())
+	{
+		m_definitionPools.resize(ActorDefinition::s_definitions.size());
+	}
+	return m_definitionPools[definition->m_index];
+}
+
+void ActorPool::AddChunk(std::vector<void*>& freeList, int& numObjects, size_t objectSize, int numNewObjects)
+{
+	// Keep every object at the default new alignment inside the chunk
+	size_t alignment = alignof(std::max_align_t);
+	size_t stride = (objectSize + alignment - 1) & ~(alignment - 1);
+	unsigned char* chunk = new unsigned char[stride * numNewObjects];
+	m_chunks.push_back(chunk);
+
+	// The free list can hold every object of the definition, so giving them back never reallocates
+	numObjects += numNewObjects;
+	freeList.reserve(numObjects);
+	for (int objectIndex = numNewObjects - 1; objectIndex >= 0; --objectIndex)
+	{
+		freeList.push_back(chunk + stride * objectIndex);
+	}
+}
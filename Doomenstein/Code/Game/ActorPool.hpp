@@ -0,0 +1,51 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/ActorHandle.hpp"
+#include <vector>
+
+class AI;
+
+//-----------------------------------------------------------------------------------------------
+// Memory for a map's actors and their AI controllers. Every actor definition has its own free
+// lists, filled up front with poolSize objects from the definition data; a definition that runs
+// dry gets another chunk of the same size. Create constructs in place and Destroy destructs and
+// hands the memory back to the definition's free list, so once the chunks exist spawning and
+// destroying does not touch the heap. Chunks are only released with the pool.
+//
+class ActorPool
+{
+public:
+	ActorPool() = default;
+	~ActorPool();
+	ActorPool(ActorPool const& copy) = delete;
+	ActorPool& operator=(ActorPool const& copy) = delete;
+
+	void ReserveFromDefinitions(); // poolSize actors, and AI controllers if aiEnabled, for every definition
+
+	Actor* CreateActor(Map* map, SpawnInfo const& spawnInfo, ActorDefinition const* definition, ActorHandle handle);
+	void DestroyActor(Actor* actor);
+	AI* CreateAI(ActorDefinition const* definition);
+	void DestroyAI(AI* ai, ActorDefinition const* definition);
+
+	int GetNumLiveActors() const { return m_numLiveActors; }
+	int GetNumPooledActors() const { return m_numPooledActors; } // live and free
+	int GetNumChunks() const { return (int)m_chunks.size(); } // heap allocations so far
+
+private:
+	struct DefinitionPool
+	{
+		std::vector<void*> m_freeActors;
+		std::vector<void*> m_freeAIs;
+		int m_numActors = 0;
+		int m_numAIs = 0;
+	};
+
+	DefinitionPool& GetDefinitionPool(ActorDefinition const* definition);
+	void AddChunk(std::vector<void*>& freeList, int& numObjects, size_t objectSize, int numNewObjects);
+
+private:
+	std::vector<DefinitionPool>	m_definitionPools; // by ActorDefinition::m_index
+	std::vector<unsigned char*>	m_chunks;
+	int							m_numLiveActors = 0;
+	int							m_numPooledActors = 0;
+};
@@ -0,0 +1,143 @@
+#include "Game/ActorSpatialGrid.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------------------------
+void ActorSpatialGrid::Initialize(IntVec2 const& dimensions)
+{
+	m_dimensions = dimensions;
+	int numCells = m_dimensions.x * m_dimensions.y;
+	m_cellStarts.assign(numCells + 1, 0);
+	m_cellCursors.assign(numCells, 0);
+	m_entries.clear();
+	m_cellEntries.clear();
+}
+
+void ActorSpatialGrid::BeginRebuild()
+{
+	m_entries.clear();
+}
+
+void ActorSpatialGrid::AddActor(int actorIndex, float centerX, float centerY, float radius)
+{
+	Entry entry;
+	entry.m_actorIndex = actorIndex;
+	entry.m_minX = centerX - radius;
+	entry.m_minY = centerY - radius;
+	entry.m_maxX = centerX + radius;
+	entry.m_maxY = centerY + radius;
+	m_entries.push_back(entry);
+}
+
+void ActorSpatialGrid::EndRebuild()
+{
+	int numCells = m_dimensions.x * m_dimensions.y;
+	std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+
+	// Count entries per cell
+	for (Entry const& entry : m_entries)
+	{
+		IntVec2 minCoords = GetCellCoordsClamped(entry.m_minX, entry.m_minY);
+		IntVec2 maxCoords = GetCellCoordsClamped(entry.m_maxX, entry.m_maxY);
+		for (int cellY = minCoords.y; cellY <= maxCoords.y; ++cellY)
+		{
+			for (int cellX = minCoords.x; cellX <= maxCoords.x; ++cellX)
+			{
+				m_cellStarts[cellX + cellY * m_dimensions.x + 1]++;
+			}
+		}
+	}
+
+	// Prefix sum
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		m_cellStarts[cellIndex + 1] += m_cellStarts[cellIndex];
+		m_cellCursors[cellIndex] = m_cellStarts[cellIndex];
+	}
+
+	// Scatter entries into their cells, in actor order
+	m_cellEntries.resize(m_cellStarts[numCells]);
+	for (int entryIndex = 0; entryIndex < (int)m_entries.size(); ++entryIndex)
+	{
+		Entry const& entry = m_entries[entryIndex];
+		IntVec2 minCoords = GetCellCoordsClamped(entry.m_minX, entry.m_minY);
+		IntVec2 maxCoords = GetCellCoordsClamped(entry.m_maxX, entry.m_maxY);
+		for (int cellY = minCoords.y; cellY <= maxCoords.y; ++cellY)
+		{
+			for (int cellX = minCoords.x; cellX <= maxCoords.x; ++cellX)
+			{
+				int cellIndex = cellX + cellY * m_dimensions.x;
+				m_cellEntries[m_cellCursors[cellIndex]++] = entryIndex;
+			}
+		}
+	}
+}
+
+void ActorSpatialGrid::GetCandidatePairs(std::vector<ActorPair>& out_pairs) const
+{
+	out_pairs.clear();
+
+	for (int cellY = 0; cellY < m_dimensions.y; ++cellY)
+	{
+		for (int cellX = 0; cellX < m_dimensions.x; ++cellX)
+		{
+			int cellIndex = cellX + cellY * m_dimensions.x;
+			int cellBegin = m_cellStarts[cellIndex];
+			int cellEnd = m_cellStarts[cellIndex + 1];
+
+			for (int i = cellBegin; i < cellEnd; ++i)
+			{
+				Entry const& entryA = m_entries[m_cellEntries[i]];
+				for (int j = i + 1; j < cellEnd; ++j)
+				{
+					Entry const& entryB = m_entries[m_cellEntries[j]];
+					if (entryA.m_maxX < entryB.m_minX || entryB.m_maxX < entryA.m_minX ||
+						entryA.m_maxY < entryB.m_minY || entryB.m_maxY < entryA.m_minY)
+					{
+						continue;
+					}
+
+					// Only the cell holding the min corner of the intersection reports the pair
+					IntVec2 ownerCoords = GetCellCoordsClamped((entryA.m_minX > entryB.m_minX) ? entryA.m_minX : entryB.m_minX,
+															   (entryA.m_minY > entryB.m_minY) ? entryA.m_minY : entryB.m_minY);
+					if (ownerCoords.x != cellX || ownerCoords.y != cellY)
+					{
+						continue;
+					}
+
+					ActorPair pair;
+					pair.m_actorIndexA = (entryA.m_actorIndex < entryB.m_actorIndex) ? entryA.m_actorIndex : entryB.m_actorIndex;
+					pair.m_actorIndexB = (entryA.m_actorIndex < entryB.m_actorIndex) ? entryB.m_actorIndex : entryA.m_actorIndex;
+					out_pairs.push_back(pair);
+				}
+			}
+		}
+	}
+
+	std::sort(out_pairs.begin(), out_pairs.end(), [](ActorPair const& a, ActorPair const& b)
+		{
+			return (a.m_actorIndexA != b.m_actorIndexA) ? (a.m_actorIndexA < b.m_actorIndexA) : (a.m_actorIndexB < b.m_actorIndexB);
+		});
+}
+
+int ActorSpatialGrid::GetNumActors() const
+{
+	return (int)m_entries.size();
+}
+
+int ActorSpatialGrid::GetCellIndexClamped(int cellX, int cellY) const
+{
+	cellX = (cellX < 0) ? 0 : ((cellX >= m_dimensions.x) ? m_dimensions.x - 1 : cellX);
+	cellY = (cellY < 0) ? 0 : ((cellY >= m_dimensions.y) ? m_dimensions.y - 1 : cellY);
+	return cellX + cellY * m_dimensions.x;
+}
+
+IntVec2 ActorSpatialGrid::GetCellCoordsClamped(float x, float y) const
+{
+	int cellX = RoundDownToInt(x);
+	int cellY = RoundDownToInt(y);
+	cellX = (cellX < 0) ? 0 : ((cellX >= m_dimensions.x) ? m_dimensions.x - 1 : cellX);
+	cellY = (cellY < 0) ? 0 : ((cellY >= m_dimensions.y) ? m_dimensions.y - 1 : cellY);
+	return IntVec2(cellX, cellY);
+}
+
@@ -0,0 +1,66 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+struct ActorPair
+{
+	int m_actorIndexA = -1; // always the smaller index
+	int m_actorIndexB = -1;
+};
+
+//-----------------------------------------------------------------------------------------------
+// Uniform grid keyed to the map's 1x1 tiles. Actors are bucketed into every tile their XY bounds
+// overlap, and each overlapping pair is reported exactly once, by the tile that holds the min
+// corner of the intersection of both bounds. Positions outside the map clamp to the border tiles.
+//
+class ActorSpatialGrid
+{
+public:
+	void Initialize(IntVec2 const& dimensions);
+
+	void BeginRebuild();
+	void AddActor(int actorIndex, float centerX, float centerY, float radius);
+	void EndRebuild(); // counting sort the actors into the tile buckets
+
+	void GetCandidatePairs(std::vector<ActorPair>& out_pairs) const; // sorted by (A, B), same order as the brute-force loop
+	int GetNumActors() const;
+
+	// Cells outside the map clamp to the border cells, the same way the actor bounds do
+	int GetCellIndexClamped(int cellX, int cellY) const;
+
+	// Calls callback(actorIndex) for every actor bucketed in the cell, in actor order
+	template <typename CALLBACK_TYPE>
+	void ForEachActorInCell(int cellIndex, CALLBACK_TYPE const& callback) const;
+
+private:
+	struct Entry
+	{
+		int m_actorIndex = -1;
+		float m_minX = 0.f;
+		float m_minY = 0.f;
+		float m_maxX = 0.f;
+		float m_maxY = 0.f;
+	};
+
+	IntVec2 GetCellCoordsClamped(float x, float y) const;
+
+private:
+	IntVec2				m_dimensions;
+	std::vector<Entry>	m_entries;
+	std::vector<int>	m_cellStarts;	// numCells + 1 prefix sums into m_cellEntries
+	std::vector<int>	m_cellCursors;	// scratch for the counting sort
+	std::vector<int>	m_cellEntries;	// entry indexes, bucketed by cell
+};
+
+
+//-----------------------------------------------------------------------------------------------
+template <typename CALLBACK_TYPE>
+void ActorSpatialGrid::ForEachActorInCell(int cellIndex, CALLBACK_TYPE const& callback) const
+{
+	int cellEnd = m_cellStarts[cellIndex + 1];
+	for (int i = m_cellStarts[cellIndex]; i < cellEnd; ++i)
+	{
+		callback(m_entries[m_cellEntries[i]].m_actorIndex);
+	}
+}
@@ -1,6 +1,7 @@
 #include "Game/App.hpp"
 #include "Game/Game.hpp"
 #include "Game/GameCommon.hpp"
+#include "Game/WorkerPool.hpp"
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Core/Clock.hpp"
@@ -20,6 +21,7 @@ Window*			g_theWindow		= nullptr;		// Created and owned by the App
 Renderer*		g_theRenderer	= nullptr;		// Created and owned by the App
 AudioSystem*    g_theAudio		= nullptr;		// Created and owned by the App
 Game*			g_theGame		= nullptr;		// Created and owned by the App
+WorkerPool*		g_theWorkerPool	= nullptr;		// Created and owned by the App
 bool			g_isDebugDraw	= false;
 RandomNumberGenerator g_rng;
 
@@ -87,6 +89,15 @@ void App::Startup()
 	g_theAudio->Startup();
 	DebugRenderSystemStartup(debugRenderConfig);
 
+	// Worker threads for the game's parallel loops, -1 means one per core besides the main thread
+	int numWorkerThreads = g_gameConfigBlackboard.GetValue("workerThreads", -1);
+	if (numWorkerThreads < 0)
+	{
+		int numCores = (int)std::thread::hardware_concurrency();
+		numWorkerThreads = (numCores > 1) ? numCores - 1 : 0;
+	}
+	g_theWorkerPool = new WorkerPool(numWorkerThreads);
+
 	// Initialize game-related stuff: create and start the game
 	g_theEventSystem->SubscribeEventCallbackFunction("Quit", OnQuitEvent);
 	g_theGame = new Game();
@@ -123,6 +134,8 @@ void App::Shutdown()
 	// Destroy game-related stuff
 	delete g_theGame;
 	g_theGame = nullptr;
+	delete g_theWorkerPool;
+	g_theWorkerPool = nullptr;
 
 	// Shut down all Engine subsystems
 	DebugRenderSystemShutdown();
@@ -0,0 +1,89 @@
+#include "Game/BackgroundJob.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+
+//-----------------------------------------------------------------------------------------------
+BackgroundJob::BackgroundJob()
+{
+}
+
+BackgroundJob::~BackgroundJob()
+{
+	if (!m_thread.joinable())
+	{
+		return; // no job was ever started
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isQuitting = true;
+	}
+	m_jobAvailable.notify_all();
+	m_thread.join();
+}
+
+void BackgroundJob::Start(std::function<void()> const& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		GUARANTEE_OR_DIE(!m_isBusy, "Background job started while the previous one is not collected");
+		m_job = job;
+		m_isBusy = true;
+		m_isRunning = true;
+	}
+
+	// The thread only exists once there is a job for it, it picks this one up as soon as it runs
+	if (!m_thread.joinable())
+	{
+		m_thread = std::thread(&BackgroundJob::ThreadMain, this);
+	}
+	m_jobAvailable.notify_one();
+}
+
+bool BackgroundJob::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_isBusy;
+}
+
+bool BackgroundJob::TryCollect()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_isBusy || m_isRunning)
+	{
+		return false;
+	}
+	m_isBusy = false;
+	return true;
+}
+
+void BackgroundJob::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobDone.wait(lock, [this]() { return !m_isRunning; });
+}
+
+//-----------------------------------------------------------------------------------------------
+void BackgroundJob::ThreadMain()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobAvailable.wait(lock, [this]() { return m_isQuitting || (m_isRunning && m_job); });
+			if (m_isQuitting && !m_isRunning)
+			{
+				return;
+			}
+			job.swap(m_job);
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isRunning = false;
+		}
+		m_jobDone.notify_all();
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//-----------------------------------------------------------------------------------------------
+// One thread that runs a single long job next to the main thread. The main thread starts a job
+// while the thread is idle, polls TryCollect once per frame and only reads the job's results after
+// it returned true. The job must not use the WorkerPool, which belongs to the main thread.
+// The thread is created by the first Start, so an owner that never starts a job costs no thread.
+//
+class BackgroundJob
+{
+public:
+	BackgroundJob();
+	~BackgroundJob(); // waits for the running job
+
+	void Start(std::function<void()> const& job); // only while not busy
+	bool IsBusy() const; // started and not collected yet
+	bool TryCollect(); // true once, when the started job has finished
+	void Wait(); // blocks until the started job has finished, it still has to be collected
+
+private:
+	void ThreadMain();
+
+private:
+	std::thread					m_thread;
+	mutable std::mutex			m_mutex;
+	std::condition_variable		m_jobAvailable;
+	std::condition_variable		m_jobDone;
+	std::function<void()>		m_job;
+	bool						m_isQuitting = false;
+	bool						m_isBusy = false;
+	bool						m_isRunning = false;
+};
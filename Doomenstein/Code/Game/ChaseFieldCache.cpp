@@ -0,0 +1,96 @@
+#include "Game/ChaseFieldCache.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+
+//-----------------------------------------------------------------------------------------------
+ChaseFieldCache::Entry::Entry(IntVec2 const& dimensions)
+	: m_flowField(dimensions)
+{
+}
+
+//-----------------------------------------------------------------------------------------------
+void ChaseFieldCache::Initialize(IntVec2 const& dimensions)
+{
+	m_dimensions = dimensions;
+	m_entries.clear();
+	m_freeEntries.clear();
+	m_numBuilds = 0;
+}
+
+int ChaseFieldCache::FindField(std::vector<IntVec2> const& goalTiles) const
+{
+	for (int entryIndex = 0; entryIndex < (int)m_entries.size(); ++entryIndex)
+	{
+		if (m_entries[entryIndex].m_isUsed && m_entries[entryIndex].m_goalTiles == goalTiles)
+		{
+			return entryIndex;
+		}
+	}
+	return -1;
+}
+
+int ChaseFieldCache::AddField(std::vector<IntVec2> const& goalTiles)
+{
+	int entryIndex = -1;
+	if (!m_freeEntries.empty())
+	{
+		entryIndex = m_freeEntries.back();
+		m_freeEntries.pop_back();
+	}
+	else
+	{
+		entryIndex = (int)m_entries.size();
+		m_entries.emplace_back(m_dimensions);
+	}
+
+	Entry& entry = m_entries[entryIndex];
+	entry.m_goalTiles = goalTiles;
+	entry.m_referenceCount = 0;
+	entry.m_isUsed = true;
+	m_numBuilds++;
+	return entryIndex;
+}
+
+void ChaseFieldCache::AddReference(int fieldId)
+{
+	GUARANTEE_OR_DIE(m_entries[fieldId].m_isUsed, "Chase field is not in the cache");
+	m_entries[fieldId].m_referenceCount++;
+}
+
+void ChaseFieldCache::RemoveReference(int fieldId)
+{
+	Entry& entry = m_entries[fieldId];
+	GUARANTEE_OR_DIE(entry.m_isUsed && entry.m_referenceCount > 0, "Chase field released more often than acquired");
+	entry.m_referenceCount--;
+	if (entry.m_referenceCount == 0)
+	{
+		entry.m_isUsed = false;
+		entry.m_goalTiles.clear();
+		m_freeEntries.push_back(fieldId);
+	}
+}
+
+TileDirectionGrid const& ChaseFieldCache::GetFlowField(int fieldId) const
+{
+	return m_entries[fieldId].m_flowField;
+}
+
+TileDirectionGrid& ChaseFieldCache::GetFlowFieldToBuild(int fieldId)
+{
+	return m_entries[fieldId].m_flowField;
+}
+
+//-----------------------------------------------------------------------------------------------
+int ChaseFieldCache::GetNumFields() const
+{
+	return (int)m_entries.size() - (int)m_freeEntries.size();
+}
+
+int ChaseFieldCache::GetNumReferences() const
+{
+	int numReferences = 0;
+	for (Entry const& entry : m_entries)
+	{
+		numReferences += entry.m_referenceCount;
+	}
+	return numReferences;
+}
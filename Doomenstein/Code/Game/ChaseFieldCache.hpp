@@ -0,0 +1,43 @@
+#pragma once
+#include "Game/TileDirectionGrid.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+// Shared flow fields toward goal tiles. Every AI chasing the same goal holds a reference to the
+// same field, so N actors chasing one player cost one build. Walls never move, so a field stays
+// valid for the whole map; it is evicted as soon as its last reference is released.
+// Field ids stay valid while the caller holds a reference.
+//
+class ChaseFieldCache
+{
+public:
+	void Initialize(IntVec2 const& dimensions);
+
+	int FindField(std::vector<IntVec2> const& goalTiles) const; // -1 if not cached, goal tiles sorted by the caller
+	int AddField(std::vector<IntVec2> const& goalTiles); // starts with no reference, the caller builds into GetFlowFieldToBuild
+	void AddReference(int fieldId);
+	void RemoveReference(int fieldId);
+	TileDirectionGrid const& GetFlowField(int fieldId) const;
+	TileDirectionGrid& GetFlowFieldToBuild(int fieldId); // entries keep their grid when recycled, so a build allocates nothing
+
+	int GetNumFields() const;
+	int GetNumReferences() const;
+	int GetNumBuilds() const { return m_numBuilds; }
+
+private:
+	struct Entry
+	{
+		Entry(IntVec2 const& dimensions);
+
+		std::vector<IntVec2> m_goalTiles;
+		TileDirectionGrid m_flowField;
+		int m_referenceCount = 0;
+		bool m_isUsed = false;
+	};
+
+	IntVec2 m_dimensions;
+	std::vector<Entry> m_entries;
+	std::vector<int> m_freeEntries;
+	int m_numBuilds = 0;
+};
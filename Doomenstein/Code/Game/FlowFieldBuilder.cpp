@@ -0,0 +1,176 @@
+#include "Game/FlowFieldBuilder.hpp"
+#include "Game/TileBitGrid.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Game/TileDistanceGrid.hpp"
+#include "Game/TileDirectionGrid.hpp"
+#include <string.h>
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------------------------
+static IntVec2 const FLOW_DIRECTION_OFFSETS[NUM_FLOW_DIRECTIONS] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0), IntVec2(1,1), IntVec2(-1,1), IntVec2(-1,-1), IntVec2(1,-1) };
+static Vec2 const FLOW_DIRECTION_VECTORS[NUM_FLOW_DIRECTIONS + 1] = { Vec2(0.f, 0.f),
+	Vec2(FLOW_DIRECTION_OFFSETS[0]).GetNormalized(), Vec2(FLOW_DIRECTION_OFFSETS[1]).GetNormalized(), Vec2(FLOW_DIRECTION_OFFSETS[2]).GetNormalized(),
+	Vec2(FLOW_DIRECTION_OFFSETS[3]).GetNormalized(), Vec2(FLOW_DIRECTION_OFFSETS[4]).GetNormalized(), Vec2(FLOW_DIRECTION_OFFSETS[5]).GetNormalized(),
+	Vec2(FLOW_DIRECTION_OFFSETS[6]).GetNormalized(), Vec2(FLOW_DIRECTION_OFFSETS[7]).GetNormalized() };
+static constexpr int FLOW_ROWS_PER_TASK = 8;
+
+//-----------------------------------------------------------------------------------------------
+void FlowFieldBuilder::Initialize(TileBitGrid const& unreachableTiles)
+{
+	m_dimensions = unreachableTiles.GetDimensions();
+	m_paddedStride = m_dimensions.x + 2;
+	int numTiles = m_dimensions.x * m_dimensions.y;
+
+	m_neighborMasks.assign(numTiles + 4, 0);
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			unsigned char mask = 0;
+			for (int directionIndex = 0; directionIndex < 4; ++directionIndex)
+			{
+				IntVec2 offset = FLOW_DIRECTION_OFFSETS[directionIndex];
+				if (!unreachableTiles.IsSet(tileX + offset.x, tileY + offset.y)) // border is unreachable
+				{
+					mask |= (unsigned char)(1 << directionIndex);
+				}
+			}
+
+			// The corner is not accessible when both cardinals next to it are blocked, or it is outside the map
+			unsigned char const cornerCardinals[4][2] = { { 0, 2 }, { 0, 3 }, { 1, 3 }, { 1, 2 } };
+			for (int directionIndex = 4; directionIndex < NUM_FLOW_DIRECTIONS; ++directionIndex)
+			{
+				unsigned char cardinalBits = (unsigned char)((1 << cornerCardinals[directionIndex - 4][0]) | (1 << cornerCardinals[directionIndex - 4][1]));
+				IntVec2 offset = FLOW_DIRECTION_OFFSETS[directionIndex];
+				int neighborX = tileX + offset.x;
+				int neighborY = tileY + offset.y;
+				bool isInBounds = neighborX >= 0 && neighborY >= 0 && neighborX < m_dimensions.x && neighborY < m_dimensions.y;
+				if (isInBounds && (mask & cardinalBits) != 0)
+				{
+					mask |= (unsigned char)(1 << directionIndex);
+				}
+			}
+			m_neighborMasks[tileX + tileY * m_dimensions.x] = mask;
+		}
+	}
+
+	m_paddedCodes.assign(m_paddedStride * (m_dimensions.y + 2) + 4, 0);
+	m_directionCodes.assign(numTiles, 0);
+}
+
+void FlowFieldBuilder::Build(TileDistanceGrid const& distanceMap, WorkerPool* workerPool, TileDirectionGrid& out_flowField)
+{
+	LoadDistanceRows(distanceMap, 0, m_dimensions.y);
+
+	std::function<void(int, int)> buildBand = [&](int beginTileY, int endTileY)
+		{
+			BuildFlowRows(beginTileY, endTileY, out_flowField);
+		};
+	if (workerPool != nullptr)
+	{
+		workerPool->ParallelFor(m_dimensions.y, FLOW_ROWS_PER_TASK, buildBand);
+	}
+	else
+	{
+		buildBand(0, m_dimensions.y);
+	}
+}
+
+void FlowFieldBuilder::LoadDistanceRows(TileDistanceGrid const& distanceMap, int beginTileY, int endTileY)
+{
+	for (int tileY = beginTileY; tileY < endTileY; ++tileY)
+	{
+		memcpy(&m_paddedCodes[(tileY + 1) * m_paddedStride + 1], &distanceMap.GetCodes()[tileY * m_dimensions.x], m_dimensions.x * sizeof(uint16_t));
+	}
+}
+
+void FlowFieldBuilder::BuildFlowRows(int beginTileY, int endTileY, TileDirectionGrid& out_flowField)
+{
+	BuildRows(beginTileY, endTileY);
+	for (int tileY = beginTileY; tileY < endTileY; ++tileY)
+	{
+		out_flowField.SetRowCodes(tileY, &m_directionCodes[tileY * m_dimensions.x]);
+	}
+}
+
+unsigned char FlowFieldBuilder::ComputeDirectionCode(TileDistanceGrid const& distanceMap, int tileIndex) const
+{
+	unsigned char neighborMask = m_neighborMasks[tileIndex];
+	int currentCode = distanceMap.GetCodeAtIndex(tileIndex);
+	unsigned char directionCode = 0;
+	int minDelta = 0;
+	for (int directionIndex = 0; directionIndex < NUM_FLOW_DIRECTIONS; ++directionIndex)
+	{
+		if ((neighborMask & (1 << directionIndex)) == 0)
+		{
+			continue; // masked neighbours may be outside the map, allowed ones never are
+		}
+		IntVec2 const& offset = FLOW_DIRECTION_OFFSETS[directionIndex];
+		int delta = (int)distanceMap.GetCodeAtIndex(tileIndex + offset.x + offset.y * m_dimensions.x) - currentCode;
+		if (delta < minDelta)
+		{
+			directionCode = (unsigned char)(directionIndex + 1);
+			minDelta = delta;
+		}
+	}
+	return directionCode;
+}
+
+IntVec2 FlowFieldBuilder::GetDirectionOffset(unsigned char directionCode)
+{
+	if (directionCode == 0)
+	{
+		return IntVec2(0, 0);
+	}
+	return FLOW_DIRECTION_OFFSETS[directionCode - 1];
+}
+
+Vec2 FlowFieldBuilder::GetDirectionVector(unsigned char directionCode)
+{
+	return FLOW_DIRECTION_VECTORS[directionCode];
+}
+
+//-----------------------------------------------------------------------------------------------
+void FlowFieldBuilder::BuildRows(int beginTileY, int endTileY)
+{
+	// Lanes past the end of a row read into the next row or the tail padding, their codes are not stored
+	int neighborOffsets[NUM_FLOW_DIRECTIONS];
+	for (int directionIndex = 0; directionIndex < NUM_FLOW_DIRECTIONS; ++directionIndex)
+	{
+		neighborOffsets[directionIndex] = FLOW_DIRECTION_OFFSETS[directionIndex].x + FLOW_DIRECTION_OFFSETS[directionIndex].y * m_paddedStride;
+	}
+	__m128i const zeroBytes = _mm_setzero_si128();
+
+	for (int tileY = beginTileY; tileY < endTileY; ++tileY)
+	{
+		uint16_t const* paddedRow = &m_paddedCodes[(tileY + 1) * m_paddedStride + 1];
+		unsigned char const* maskRow = &m_neighborMasks[tileY * m_dimensions.x];
+		unsigned char* codeRow = &m_directionCodes[tileY * m_dimensions.x];
+
+		for (int tileX = 0; tileX < m_dimensions.x; tileX += 4)
+		{
+			int maskBytes = 0;
+			memcpy(&maskBytes, &maskRow[tileX], 4);
+			__m128i masks = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(maskBytes), zeroBytes), zeroBytes);
+
+			// 4 distance codes widened to 32 bits, so the deltas can not overflow
+			__m128i currentCodes = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)&paddedRow[tileX]), zeroBytes);
+			__m128i minDeltas = _mm_setzero_si128();
+			__m128i codes = _mm_setzero_si128();
+			for (int directionIndex = 0; directionIndex < NUM_FLOW_DIRECTIONS; ++directionIndex)
+			{
+				__m128i directionBit = _mm_set1_epi32(1 << directionIndex);
+				__m128i isAllowed = _mm_cmpeq_epi32(_mm_and_si128(masks, directionBit), directionBit);
+				__m128i neighborCodes = _mm_unpacklo_epi16(_mm_loadl_epi64((__m128i const*)&paddedRow[tileX + neighborOffsets[directionIndex]]), zeroBytes);
+				__m128i deltas = _mm_sub_epi32(neighborCodes, currentCodes);
+				__m128i isBetter = _mm_and_si128(isAllowed, _mm_cmplt_epi32(deltas, minDeltas));
+				minDeltas = _mm_or_si128(_mm_and_si128(isBetter, deltas), _mm_andnot_si128(isBetter, minDeltas));
+				codes = _mm_or_si128(_mm_and_si128(isBetter, _mm_set1_epi32(directionIndex + 1)), _mm_andnot_si128(isBetter, codes));
+			}
+
+			int codeBytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(codes, codes), zeroBytes));
+			int numLanes = (m_dimensions.x - tileX < 4) ? (m_dimensions.x - tileX) : 4;
+			memcpy(&codeRow[tileX], &codeBytes, numLanes);
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <stdint.h>
+#include <vector>
+
+class TileBitGrid;
+class TileDistanceGrid;
+class TileDirectionGrid;
+class WorkerPool;
+
+//-----------------------------------------------------------------------------------------------
+constexpr int NUM_FLOW_DIRECTIONS = 8; // N, S, E, W, NE, NW, SW, SE, also the tie-break order
+
+//-----------------------------------------------------------------------------------------------
+// Builds the flow field of a distance map 4 tiles at a time with SSE. Every tile steps to the
+// neighbour with the most negative delta (first one wins ties, no step unless the delta is below 0).
+// Cardinal neighbours must be reachable; a diagonal is skipped when both cardinals next to it are
+// unreachable or it is outside the map. Those rules only depend on the map, so they are baked into
+// one mask byte per tile from the reachability bits. Rows are split into bands on the worker pool,
+// and the result is a direction code per tile (0 = stay, i + 1 = direction i), packed into the
+// direction grid. Distance codes are monotonic in distance, so the deltas are taken on the codes.
+//
+class FlowFieldBuilder
+{
+public:
+	void Initialize(TileBitGrid const& unreachableTiles);
+	void Build(TileDistanceGrid const& distanceMap, WorkerPool* workerPool, TileDirectionGrid& out_flowField);
+
+	// Resumable form of Build: load every row of the distance map first, then build the flow rows in any order
+	void LoadDistanceRows(TileDistanceGrid const& distanceMap, int beginTileY, int endTileY);
+	void BuildFlowRows(int beginTileY, int endTileY, TileDirectionGrid& out_flowField);
+
+	// One tile with the same rules and tie-break, for on demand evaluation; thread safe, needs no Load
+	unsigned char ComputeDirectionCode(TileDistanceGrid const& distanceMap, int tileIndex) const;
+
+	unsigned char const* GetDirectionCodes() const { return m_directionCodes.data(); }
+	unsigned char GetNeighborMask(int tileIndex) const { return m_neighborMasks[tileIndex]; }
+	static Vec2 GetDirectionVector(unsigned char directionCode); // unit vector, zero for 0
+	static IntVec2 GetDirectionOffset(unsigned char directionCode);
+
+private:
+	void BuildRows(int beginTileY, int endTileY);
+
+private:
+	IntVec2						m_dimensions;
+	int							m_paddedStride = 0;		// dimensions.x + 2
+	std::vector<unsigned char>	m_neighborMasks;		// bit i = direction i may be taken, 4 bytes of tail padding
+	std::vector<uint16_t>		m_paddedCodes;			// distance codes with a one tile border, 4 codes of tail padding
+	std::vector<unsigned char>	m_directionCodes;
+};
@@ -0,0 +1,147 @@
+#include "Game/FlowFieldSampler.hpp"
+#include "Game/TileDirectionGrid.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <emmintrin.h>
+#include <math.h>
+
+//-----------------------------------------------------------------------------------------------
+void FlowFieldSampler::Load(TileDirectionGrid const& flowField)
+{
+	m_dimensions = flowField.GetDimensions();
+	m_paddedStride = m_dimensions.x + 2;
+	int numPaddedTiles = m_paddedStride * (m_dimensions.y + 2);
+	m_paddedX.assign(numPaddedTiles, 0.f);
+	m_paddedY.assign(numPaddedTiles, 0.f);
+
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			Vec2 direction = flowField.GetDirection(IntVec2(tileX, tileY));
+			int paddedIndex = (tileX + 1) + (tileY + 1) * m_paddedStride;
+			m_paddedX[paddedIndex] = direction.x;
+			m_paddedY[paddedIndex] = direction.y;
+		}
+	}
+
+	// Border: edges point straight back into the map, corners diagonally
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		m_paddedX[(tileY + 1) * m_paddedStride] = 1.f;
+		m_paddedX[(tileY + 1) * m_paddedStride + m_dimensions.x + 1] = -1.f;
+	}
+	for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+	{
+		m_paddedY[tileX + 1] = 1.f;
+		m_paddedY[(tileX + 1) + (m_dimensions.y + 1) * m_paddedStride] = -1.f;
+	}
+	Vec2 cornerDirection = Vec2(1.f, 1.f).GetNormalized();
+	int topRowIndex = (m_dimensions.y + 1) * m_paddedStride;
+	m_paddedX[0] = cornerDirection.x;
+	m_paddedY[0] = cornerDirection.y;
+	m_paddedX[m_dimensions.x + 1] = -cornerDirection.x;
+	m_paddedY[m_dimensions.x + 1] = cornerDirection.y;
+	m_paddedX[topRowIndex] = cornerDirection.x;
+	m_paddedY[topRowIndex] = -cornerDirection.y;
+	m_paddedX[topRowIndex + m_dimensions.x + 1] = -cornerDirection.x;
+	m_paddedY[topRowIndex + m_dimensions.x + 1] = -cornerDirection.y;
+}
+
+void FlowFieldSampler::LoadTiles(TileDirectionGrid const& flowField, IntVec2 const& minTile, IntVec2 const& maxTile)
+{
+	for (int tileY = minTile.y; tileY <= maxTile.y; ++tileY)
+	{
+		for (int tileX = minTile.x; tileX <= maxTile.x; ++tileX)
+		{
+			SetTileDirection(tileX, tileY, flowField.GetDirection(IntVec2(tileX, tileY)));
+		}
+	}
+}
+
+void FlowFieldSampler::SetTileDirection(int tileX, int tileY, Vec2 const& direction)
+{
+	int paddedIndex = (tileX + 1) + (tileY + 1) * m_paddedStride;
+	m_paddedX[paddedIndex] = direction.x;
+	m_paddedY[paddedIndex] = direction.y;
+}
+
+void FlowFieldSampler::SampleDirections(int count, float const* positionsX, float const* positionsY, float* out_directionsX, float* out_directionsY) const
+{
+	// Same math as Map::GetBilinearInterpResultFromWorldPos: the 2x2 tile centers around the position, x then y, normalized
+	__m128 const half = _mm_set1_ps(0.5f);
+	__m128 const one = _mm_set1_ps(1.f);
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const minCorner = _mm_set1_ps(-1.f);
+	__m128 const maxCornerX = _mm_set1_ps(static_cast<float>(m_dimensions.x - 1));
+	__m128 const maxCornerY = _mm_set1_ps(static_cast<float>(m_dimensions.y - 1));
+
+	for (int first = 0; first < count; first += 4)
+	{
+		int numLanes = (count - first < 4) ? (count - first) : 4;
+		float laneX[4] = { 0.f, 0.f, 0.f, 0.f };
+		float laneY[4] = { 0.f, 0.f, 0.f, 0.f };
+		for (int lane = 0; lane < numLanes; ++lane)
+		{
+			laneX[lane] = positionsX[first + lane];
+			laneY[lane] = positionsY[first + lane];
+		}
+
+		// floor with SSE2: truncate, then step down where truncation rounded up
+		__m128 cornerX = _mm_sub_ps(_mm_loadu_ps(laneX), half);
+		__m128 cornerY = _mm_sub_ps(_mm_loadu_ps(laneY), half);
+		__m128 floorX = _mm_cvtepi32_ps(_mm_cvttps_epi32(cornerX));
+		__m128 floorY = _mm_cvtepi32_ps(_mm_cvttps_epi32(cornerY));
+		floorX = _mm_sub_ps(floorX, _mm_and_ps(_mm_cmplt_ps(cornerX, floorX), one));
+		floorY = _mm_sub_ps(floorY, _mm_and_ps(_mm_cmplt_ps(cornerY, floorY), one));
+		__m128 xWeights = _mm_sub_ps(cornerX, floorX);
+		__m128 yWeights = _mm_sub_ps(cornerY, floorY);
+
+		int tileXs[4];
+		int tileYs[4];
+		_mm_storeu_si128((__m128i*)tileXs, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(floorX, minCorner), maxCornerX)));
+		_mm_storeu_si128((__m128i*)tileYs, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(floorY, minCorner), maxCornerY)));
+
+		float valuesX[4][4]; // [corner][lane], corners 00, 01, 10, 11
+		float valuesY[4][4];
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			int paddedIndex = (tileXs[lane] + 1) + (tileYs[lane] + 1) * m_paddedStride;
+			valuesX[0][lane] = m_paddedX[paddedIndex];
+			valuesY[0][lane] = m_paddedY[paddedIndex];
+			valuesX[1][lane] = m_paddedX[paddedIndex + m_paddedStride];
+			valuesY[1][lane] = m_paddedY[paddedIndex + m_paddedStride];
+			valuesX[2][lane] = m_paddedX[paddedIndex + 1];
+			valuesY[2][lane] = m_paddedY[paddedIndex + 1];
+			valuesX[3][lane] = m_paddedX[paddedIndex + m_paddedStride + 1];
+			valuesY[3][lane] = m_paddedY[paddedIndex + m_paddedStride + 1];
+		}
+
+		__m128 value00X = _mm_loadu_ps(valuesX[0]);
+		__m128 value01X = _mm_loadu_ps(valuesX[1]);
+		__m128 value00Y = _mm_loadu_ps(valuesY[0]);
+		__m128 value01Y = _mm_loadu_ps(valuesY[1]);
+		__m128 topX = _mm_add_ps(value01X, _mm_mul_ps(xWeights, _mm_sub_ps(_mm_loadu_ps(valuesX[3]), value01X)));
+		__m128 topY = _mm_add_ps(value01Y, _mm_mul_ps(xWeights, _mm_sub_ps(_mm_loadu_ps(valuesY[3]), value01Y)));
+		__m128 bottomX = _mm_add_ps(value00X, _mm_mul_ps(xWeights, _mm_sub_ps(_mm_loadu_ps(valuesX[2]), value00X)));
+		__m128 bottomY = _mm_add_ps(value00Y, _mm_mul_ps(xWeights, _mm_sub_ps(_mm_loadu_ps(valuesY[2]), value00Y)));
+		__m128 resultX = _mm_add_ps(bottomX, _mm_mul_ps(yWeights, _mm_sub_ps(topX, bottomX)));
+		__m128 resultY = _mm_add_ps(bottomY, _mm_mul_ps(yWeights, _mm_sub_ps(topY, bottomY)));
+
+		// Zero length stays zero
+		__m128 lengths = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(resultX, resultX), _mm_mul_ps(resultY, resultY)));
+		__m128 hasLength = _mm_cmpgt_ps(lengths, zero);
+		__m128 safeLengths = _mm_or_ps(_mm_and_ps(hasLength, lengths), _mm_andnot_ps(hasLength, one));
+		resultX = _mm_and_ps(hasLength, _mm_div_ps(resultX, safeLengths));
+		resultY = _mm_and_ps(hasLength, _mm_div_ps(resultY, safeLengths));
+
+		float directionsX[4];
+		float directionsY[4];
+		_mm_storeu_ps(directionsX, resultX);
+		_mm_storeu_ps(directionsY, resultY);
+		for (int lane = 0; lane < numLanes; ++lane)
+		{
+			out_directionsX[first + lane] = directionsX[lane];
+			out_directionsY[first + lane] = directionsY[lane];
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+class TileDirectionGrid;
+struct Vec2;
+
+//-----------------------------------------------------------------------------------------------
+// Bilinear steering samples of a flow field, 4 positions at a time with SSE. Load decodes the field
+// into x and y planes with a one tile border that holds the out of bounds directions of
+// Map::GetSafeValueFromFlowField (edges and corners point back into the map), so a sample never
+// branches on the map edge. Positions are expected inside the map; outside of it they are clamped
+// to the border tiles.
+//
+class FlowFieldSampler
+{
+public:
+	void Load(TileDirectionGrid const& flowField);
+	void LoadTiles(TileDirectionGrid const& flowField, IntVec2 const& minTile, IntVec2 const& maxTile); // inclusive rect, after a full Load
+	void SetTileDirection(int tileX, int tileY, Vec2 const& direction); // in bounds only
+	void SampleDirections(int count, float const* positionsX, float const* positionsY, float* out_directionsX, float* out_directionsY) const;
+
+private:
+	IntVec2				m_dimensions;
+	int					m_paddedStride = 0; // dimensions.x + 2
+	std::vector<float>	m_paddedX;
+	std::vector<float>	m_paddedY;
+};
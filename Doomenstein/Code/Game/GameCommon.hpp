@@ -31,6 +31,7 @@ class	Actor;
 class	Map;
 class	Controller;
 class	RandomNumberGenerator;
+class	WorkerPool;
 struct	MapDefinition;
 struct	TileDefinition;
 struct	ActorDefinition;
@@ -46,6 +47,7 @@ extern Window*			g_theWindow;
 extern App*				g_theApp;
 extern Game*			g_theGame;
 extern RandomNumberGenerator g_rng;
+extern WorkerPool*		g_theWorkerPool;
 
 //-----------------------------------------------------------------------------------------------
 extern bool g_isDebugDraw;
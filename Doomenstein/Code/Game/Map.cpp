@@ -5,7 +5,15 @@
 #include "Game/MapDefinition.hpp"
 #include "Game/ActorDefinition.hpp"
 #include "Game/TileDefinition.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Game/TileFieldOfView.hpp"
+#include "Game/Controller.hpp"
+#include "Game/AI.hpp"
+#include "Game/TileDistanceGrid.hpp"
+#include "Game/TileDirectionGrid.hpp"
+#include "Game/VoxelRayBatch.hpp"
 #include "Engine/Core/Clock.hpp"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Core/Vertex_PCUTBN.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Core/DebugRender.hpp"
@@ -20,14 +28,33 @@
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/VertexBuffer.hpp"
 #include "Engine/Renderer/IndexBuffer.hpp"
+#include <algorithm>
+#include <float.h>
 
 
 static constexpr float UNREACHABLE_VALUE = 1.f;
-static constexpr float SPECIAL_VALUE_POS = 999999.f;
+static constexpr float SPECIAL_VALUE_POS = TILE_DISTANCE_INFINITE;
 static constexpr float SPECIAL_VALUE_NEG = -1.f;
 static constexpr float EXPOSED_VALUE = 10000.f;
 static constexpr float UNEXPOSED_VALUE = 0.f;
 static float SIGHT_RANGE = 15.f;
+static constexpr int WALL_DISTANCE_SEARCH_RADIUS = 8; // tiles farther than this from any wall store the search radius + 0.5
+static constexpr float WALL_CLEARANCE_EPSILON = 0.001f;
+static constexpr int EXPOSURE_ROWS_PER_TASK = 4;
+static constexpr int NAV_SLICE_SPREAD_TILES = 256; // tiles per time sliced spread step
+
+//-----------------------------------------------------------------------------------------------
+static void RunParallelFor(WorkerPool* workerPool, int count, int batchSize, std::function<void(int begin, int end)> const& task)
+{
+	if (workerPool != nullptr)
+	{
+		workerPool->ParallelFor(count, batchSize, task);
+	}
+	else
+	{
+		task(0, count);
+	}
+}
 
 //-----------------------------------------------------------------------------------------------
 Map::Map(Game* game, const MapDefinition* definition)
@@ -36,15 +63,119 @@ Map::Map(Game* game, const MapDefinition* definition)
 	, m_texture(definition->m_spriteSheetTexture)
 	, m_shader(definition->m_shader)
 {
+	std::string broadphaseName = g_gameConfigBlackboard.GetValue("actorBroadphase", "UniformGrid");
+	if (broadphaseName == "BruteForce")
+	{
+		m_actorBroadphaseMode = ActorBroadphaseMode::BRUTE_FORCE;
+	}
+	else if (broadphaseName == "UniformGrid")
+	{
+		m_actorBroadphaseMode = ActorBroadphaseMode::UNIFORM_GRID;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown actorBroadphase in GameConfig: \"%s\"", broadphaseName.c_str()));
+	}
+
+	std::string narrowphaseName = g_gameConfigBlackboard.GetValue("actorNarrowphase", "Batched");
+	if (narrowphaseName == "Scalar")
+	{
+		m_actorNarrowphaseMode = ActorNarrowphaseMode::SCALAR;
+	}
+	else if (narrowphaseName == "Batched")
+	{
+		m_actorNarrowphaseMode = ActorNarrowphaseMode::BATCHED;
+	}
+	else if (narrowphaseName == "Jacobi")
+	{
+		m_actorNarrowphaseMode = ActorNarrowphaseMode::JACOBI;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown actorNarrowphase in GameConfig: \"%s\"", narrowphaseName.c_str()));
+	}
+	m_numJacobiIterations = g_gameConfigBlackboard.GetValue("actorJacobiIterations", m_numJacobiIterations);
+
+	std::string actorRaycastName = g_gameConfigBlackboard.GetValue("actorRaycast", "Traversal");
+	if (actorRaycastName == "BruteForce")
+	{
+		m_actorRaycastMode = ActorRaycastMode::BRUTE_FORCE;
+	}
+	else if (actorRaycastName == "Traversal")
+	{
+		m_actorRaycastMode = ActorRaycastMode::TRAVERSAL;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown actorRaycast in GameConfig: \"%s\"", actorRaycastName.c_str()));
+	}
+
+	std::string visibilityName = g_gameConfigBlackboard.GetValue("exposureVisibility", "Shadowcast");
+	if (visibilityName == "Raycast")
+	{
+		m_exposureVisibilityMode = ExposureVisibilityMode::RAYCAST;
+	}
+	else if (visibilityName == "Shadowcast")
+	{
+		m_exposureVisibilityMode = ExposureVisibilityMode::SHADOWCAST;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown exposureVisibility in GameConfig: \"%s\"", visibilityName.c_str()));
+	}
+
+	std::string navUpdateName = g_gameConfigBlackboard.GetValue("navUpdate", "Thread");
+	if (navUpdateName == "Blocking")
+	{
+		m_navUpdateMode = NavUpdateMode::BLOCKING;
+	}
+	else if (navUpdateName == "Thread")
+	{
+		m_navUpdateMode = NavUpdateMode::BACKGROUND_THREAD;
+	}
+	else if (navUpdateName == "TimeSliced")
+	{
+		m_navUpdateMode = NavUpdateMode::TIME_SLICED;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown navUpdate in GameConfig: \"%s\"", navUpdateName.c_str()));
+	}
+	m_navSliceMicroseconds = g_gameConfigBlackboard.GetValue("navSliceMicroseconds", m_navSliceMicroseconds);
+
+	std::string flowEvaluationName = g_gameConfigBlackboard.GetValue("flowFieldEvaluation", "Full");
+	if (flowEvaluationName == "Full")
+	{
+		m_isFlowFieldLazy = false;
+	}
+	else if (flowEvaluationName == "Lazy")
+	{
+		m_isFlowFieldLazy = true;
+	}
+	else
+	{
+		ERROR_AND_DIE(Stringf("Unknown flowFieldEvaluation in GameConfig: \"%s\"", flowEvaluationName.c_str()));
+	}
+
 	//delete g_theGame->m_player;
 	//g_theGame->m_player = new Player();
 
 
 	CreateTiles();
+	CreateWallDistanceField();
 	CreateGeometry();
 	CreateBuffers();
 	CreateSpawnPoints();
 	CreateNavGrids();
+	CreateTileVisibilitySet();
+
+	// Actor memory and slots for the whole map up front, spawning after this reuses them
+	m_actorPool.ReserveFromDefinitions();
+	int numPooledActors = m_actorPool.GetNumPooledActors();
+	m_allActors.reserve(numPooledActors);
+	m_liveActors.reserve(numPooledActors);
+	m_actorSlotGenerations.reserve(numPooledActors);
+	m_freeActorSlots.reserve(numPooledActors);
 	SpawnNonPlayerActors();
 
 	for (int playerIndex = 0; playerIndex < (int)g_theGame->m_players.size(); ++playerIndex)
@@ -56,20 +187,25 @@ Map::Map(Game* game, const MapDefinition* definition)
 
 Map::~Map()
 {
+	// The nav job writes the back buffers
+	m_navJob.Wait();
+
 	delete m_vertexBuffer;
 	m_vertexBuffer = nullptr;
 	delete m_indexBuffer;
 	m_indexBuffer = nullptr;
 
-	for (Actor* actor : m_allActors)
+	for (Actor* actor : m_liveActors)
 	{
-		delete actor;
+		m_actorPool.DestroyActor(actor);
 	}
+	m_liveActors.clear();
 	m_allActors.clear();
 
-	delete m_reachableMap;
 	delete m_exposureMap;
 	delete m_flowField;
+	delete m_backExposureMap;
+	delete m_backFlowField;
 
 }
 
@@ -77,8 +213,11 @@ Map::~Map()
 void Map::Update()
 {
 	UpdateActors();
+	ResolveSpatialQueries();
+	UpdateActorPhysics();
 	CollideActors();
 	CollideActorsWithMap();
+	CopyActorPhysicsToActors();
 	DeleteDestroyedActors();
 	CheckAndSpawnPlayers();
 	UpdateNavGrids();
@@ -87,19 +226,97 @@ void Map::Update()
 void Map::UpdateActors()
 {
 	float deltaSeconds = static_cast<float>(m_game->m_clock->GetDeltaSeconds());
-	std::vector<Actor*> actorsCopy = m_allActors; // prevent possible infinite loop
+	UpdateFleeSteering();
+
+	std::vector<Actor*> actorsCopy = m_liveActors; // prevent possible infinite loop
 
 	for (Actor* actor : actorsCopy)
 	{
-		if (actor != nullptr)
+		actor->Update(deltaSeconds);
+	}
+}
+
+void Map::UpdateFleeSteering()
+{
+	// Every fleeing AI samples the flow field in one batch, AI::HandleFleeState consumes its direction
+	m_fleeingAIs.clear();
+	m_fleePositionsX.clear();
+	m_fleePositionsY.clear();
+	for (Actor* actor : m_liveActors)
+	{
+		if (!IsAlive(actor) || actor->m_controller == nullptr || !actor->m_controller->IsAIController())
+		{
+			continue;
+		}
+		AI* aiController = static_cast<AI*>(actor->m_controller);
+		if (aiController->IsFleeing())
+		{
+			m_fleeingAIs.push_back(aiController);
+			m_fleePositionsX.push_back(actor->m_position.x);
+			m_fleePositionsY.push_back(actor->m_position.y);
+		}
+	}
+	int numFleeingAIs = (int)m_fleeingAIs.size();
+	if (numFleeingAIs == 0)
+	{
+		return;
+	}
+
+	if (m_isFlowFieldLazy)
+	{
+		// Only the tiles under fleeing AI are brought up to date, in the flow field and the sampler alike
+		for (int fleeIndex = 0; fleeIndex < numFleeingAIs; ++fleeIndex)
 		{
-			actor->Update(deltaSeconds);
+			EvaluateFlowTilesAround(Vec2(m_fleePositionsX[fleeIndex], m_fleePositionsY[fleeIndex]));
 		}
 	}
+	else if (m_flowFieldSamplerVersion != m_flowFieldVersion)
+	{
+		m_flowFieldSampler.Load(*m_flowField);
+		m_flowFieldSamplerVersion = m_flowFieldVersion;
+	}
+	m_fleeDirectionsX.resize(numFleeingAIs);
+	m_fleeDirectionsY.resize(numFleeingAIs);
+	m_flowFieldSampler.SampleDirections(numFleeingAIs, m_fleePositionsX.data(), m_fleePositionsY.data(), m_fleeDirectionsX.data(), m_fleeDirectionsY.data());
+	for (int fleeIndex = 0; fleeIndex < numFleeingAIs; ++fleeIndex)
+	{
+		m_fleeingAIs[fleeIndex]->SetFleeDirection(Vec2(m_fleeDirectionsX[fleeIndex], m_fleeDirectionsY[fleeIndex]));
+	}
+}
+
+void Map::ResolveSpatialQueries()
+{
+	// Built here so the workers only ever read it
+	UpdateActorRaycastGrid();
+	m_spatialQueries.Resolve(*this, g_theWorkerPool);
+}
+
+void Map::UpdateActorPhysics()
+{
+	float deltaSeconds = static_cast<float>(m_game->m_clock->GetDeltaSeconds());
+	m_actorPhysics.Integrate(deltaSeconds);
+	m_isActorRaycastGridDirty = true;
 }
 
 void Map::CollideActors()
 {
+	double startTime = GetCurrentTimeSeconds();
+
+	if (m_actorBroadphaseMode == ActorBroadphaseMode::BRUTE_FORCE)
+	{
+		CollideActorsBruteForce();
+	}
+	else
+	{
+		CollideActorsUsingGrid();
+	}
+
+	m_actorCollisionMilliseconds = (GetCurrentTimeSeconds() - startTime) * 1000.0;
+}
+
+void Map::CollideActorsBruteForce()
+{
+	m_numActorPairsTested = 0;
 	int numActor = (int)m_allActors.size();
 	for (int actorIndexA = 0; actorIndexA < numActor; ++actorIndexA)
 	{
@@ -113,37 +330,149 @@ void Map::CollideActors()
 			{
 				continue;
 			}
+			m_numActorPairsTested++;
 			CollideActor(m_allActors[actorIndexA], m_allActors[actorIndexB]);
 		}
 	}
 }
 
-
-
-void Map::CollideActor(Actor* actorA, Actor* actorB)
+void Map::CollideActorsUsingGrid()
 {
-	if (!actorA->m_definition->m_collision.m_collidesWithActors || !actorB->m_definition->m_collision.m_collidesWithActors)
+	m_actorGrid.BeginRebuild();
+	for (int slot = 0; slot < m_actorPhysics.GetNumSlots(); ++slot)
+	{
+		if (!m_actorPhysics.HasFlags(slot, ACTOR_PHYSICS_FLAG_ALIVE | ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS))
+		{
+			continue;
+		}
+		m_actorGrid.AddActor(slot, m_actorPhysics.m_positionX[slot], m_actorPhysics.m_positionY[slot], m_actorPhysics.m_radius[slot]);
+	}
+	m_actorGrid.EndRebuild();
+	m_actorGrid.GetCandidatePairs(m_actorPairs);
+	m_numActorPairsTested = (int)m_actorPairs.size();
+
+	if (m_actorNarrowphaseMode == ActorNarrowphaseMode::BATCHED)
 	{
+		CollideActorPairsBatched();
 		return;
 	}
-	// projectile vs. projectile and projectile vs. owner
-	// same owner
-	if (actorA->m_owner == actorB->m_owner && actorA->m_owner.IsValid())
+	if (m_actorNarrowphaseMode == ActorNarrowphaseMode::JACOBI)
 	{
+		CollideActorPairsJacobi();
 		return;
 	}
-	// A owns B / B owns A
-	if (actorA->m_owner == actorB->m_handle || actorB->m_owner == actorA->m_handle)
+
+	// Pairs come sorted the same way as the brute-force loop, so A is only checked when its row starts
+	int currentActorIndexA = -1;
+	bool isCurrentActorAAlive = false;
+	for (ActorPair const& pair : m_actorPairs)
+	{
+		if (pair.m_actorIndexA != currentActorIndexA)
+		{
+			currentActorIndexA = pair.m_actorIndexA;
+			isCurrentActorAAlive = IsAlive(m_allActors[currentActorIndexA]);
+		}
+		if (!isCurrentActorAAlive || !IsAlive(m_allActors[pair.m_actorIndexB]))
+		{
+			continue;
+		}
+		CollideActor(m_allActors[pair.m_actorIndexA], m_allActors[pair.m_actorIndexB]);
+	}
+}
+
+void Map::CollideActorPairsBatched()
+{
+	// Same walk as the scalar loop above, but pushes are done by ActorNarrowphase a batch at a time and OnCollide is
+	// applied after each batch in pair order. Only lethal actors can change who is alive in OnCollide, so a batch is
+	// closed right after the first lethal pair and the alive checks for the following pairs see its result.
+	int numPairs = (int)m_actorPairs.size();
+	int currentActorIndexA = -1;
+	bool isCurrentActorAAlive = false;
+	int pairIndex = 0;
+	while (pairIndex < numPairs)
+	{
+		m_actorPairBatch.clear();
+		for (; pairIndex < numPairs; ++pairIndex)
+		{
+			ActorPair const& pair = m_actorPairs[pairIndex];
+			if (pair.m_actorIndexA != currentActorIndexA)
+			{
+				currentActorIndexA = pair.m_actorIndexA;
+				isCurrentActorAAlive = IsAlive(m_allActors[currentActorIndexA]);
+			}
+			if (!isCurrentActorAAlive || !IsAlive(m_allActors[pair.m_actorIndexB]) || !CanActorsCollide(m_allActors[pair.m_actorIndexA], m_allActors[pair.m_actorIndexB]))
+			{
+				continue;
+			}
+			m_actorPairBatch.push_back(pair);
+			if (m_actorPhysics.HasFlags(pair.m_actorIndexA, ACTOR_PHYSICS_FLAG_LETHAL_ON_COLLIDE) || m_actorPhysics.HasFlags(pair.m_actorIndexB, ACTOR_PHYSICS_FLAG_LETHAL_ON_COLLIDE))
+			{
+				++pairIndex;
+				break;
+			}
+		}
+
+		m_actorNarrowphase.PushPairs(m_actorPhysics, m_actorPairBatch.data(), (int)m_actorPairBatch.size(), m_actorPairBatchPushed);
+
+		for (int batchIndex = 0; batchIndex < (int)m_actorPairBatch.size(); ++batchIndex)
+		{
+			if (m_actorPairBatchPushed[batchIndex])
+			{
+				Actor* actorA = m_allActors[m_actorPairBatch[batchIndex].m_actorIndexA];
+				Actor* actorB = m_allActors[m_actorPairBatch[batchIndex].m_actorIndexB];
+				actorA->OnCollide(actorB);
+				actorB->OnCollide(actorA);
+			}
+		}
+	}
+}
+
+
+
+void Map::CollideActorPairsJacobi()
+{
+	// Every pair is resolved against the positions at the start of the pass, so who is alive is only checked once up front.
+	// OnCollide still runs in pair order afterwards, skipping pairs whose actors were killed by an earlier callback.
+	m_actorPairBatch.clear();
+	for (ActorPair const& pair : m_actorPairs)
+	{
+		Actor* actorA = m_allActors[pair.m_actorIndexA];
+		Actor* actorB = m_allActors[pair.m_actorIndexB];
+		if (IsAlive(actorA) && IsAlive(actorB) && CanActorsCollide(actorA, actorB))
+		{
+			m_actorPairBatch.push_back(pair);
+		}
+	}
+
+	m_actorNarrowphase.ResolvePairsJacobi(m_actorPhysics, m_actorPairBatch.data(), (int)m_actorPairBatch.size(), m_numJacobiIterations, g_theWorkerPool, m_actorPairBatchPushed);
+
+	for (int batchIndex = 0; batchIndex < (int)m_actorPairBatch.size(); ++batchIndex)
+	{
+		Actor* actorA = m_allActors[m_actorPairBatch[batchIndex].m_actorIndexA];
+		Actor* actorB = m_allActors[m_actorPairBatch[batchIndex].m_actorIndexB];
+		if (m_actorPairBatchPushed[batchIndex] && IsAlive(actorA) && IsAlive(actorB))
+		{
+			actorA->OnCollide(actorB);
+			actorB->OnCollide(actorA);
+		}
+	}
+}
+
+void Map::CollideActor(Actor* actorA, Actor* actorB)
+{
+	if (!CanActorsCollide(actorA, actorB))
 	{
 		return;
 	}
+	int slotA = (int)actorA->m_handle.GetIndex();
+	int slotB = (int)actorB->m_handle.GetIndex();
 
-	FloatRange	zRangeA = FloatRange(actorA->m_position.z, actorA->m_position.z + actorA->m_definition->m_collision.m_physicsHeight);
-	FloatRange	zRangeB = FloatRange(actorB->m_position.z, actorB->m_position.z + actorB->m_definition->m_collision.m_physicsHeight);
-	float		radiusA = actorA->m_definition->m_collision.m_physicsRadius;
-	float		radiusB = actorB->m_definition->m_collision.m_physicsRadius;
-	Vec2		centerA = Vec2(actorA->m_position.x, actorA->m_position.y);
-	Vec2		centerB = Vec2(actorB->m_position.x, actorB->m_position.y);
+	FloatRange	zRangeA = FloatRange(m_actorPhysics.m_positionZ[slotA], m_actorPhysics.m_positionZ[slotA] + m_actorPhysics.m_height[slotA]);
+	FloatRange	zRangeB = FloatRange(m_actorPhysics.m_positionZ[slotB], m_actorPhysics.m_positionZ[slotB] + m_actorPhysics.m_height[slotB]);
+	float		radiusA = m_actorPhysics.m_radius[slotA];
+	float		radiusB = m_actorPhysics.m_radius[slotB];
+	Vec2		centerA = Vec2(m_actorPhysics.m_positionX[slotA], m_actorPhysics.m_positionY[slotA]);
+	Vec2		centerB = Vec2(m_actorPhysics.m_positionX[slotB], m_actorPhysics.m_positionY[slotB]);
 
 	//if (DoZCylindersOverlap3D(centerA, radiusA, zRangeA, centerB, radiusB, zRangeB))
 	//{
@@ -181,8 +510,8 @@ void Map::CollideActor(Actor* actorA, Actor* actorB)
 	//-----------------------------------------------------------------------------------------------
 	if (zRangeA.IsOverlappingWith(zRangeB))
 	{
-		bool isSimulatedA = actorA->m_definition->m_physics.m_simulated;
-		bool isSimulatedB = actorB->m_definition->m_physics.m_simulated;
+		bool isSimulatedA = m_actorPhysics.HasFlags(slotA, ACTOR_PHYSICS_FLAG_SIMULATED);
+		bool isSimulatedB = m_actorPhysics.HasFlags(slotB, ACTOR_PHYSICS_FLAG_SIMULATED);
 
 		bool isPushed = false;
 		if (isSimulatedA && isSimulatedB)
@@ -200,10 +529,10 @@ void Map::CollideActor(Actor* actorA, Actor* actorB)
 
 		if (isPushed)
 		{
-			actorA->m_position.x = centerA.x;
-			actorA->m_position.y = centerA.y;
-			actorB->m_position.x = centerB.x;
-			actorB->m_position.y = centerB.y;
+			m_actorPhysics.m_positionX[slotA] = centerA.x;
+			m_actorPhysics.m_positionY[slotA] = centerA.y;
+			m_actorPhysics.m_positionX[slotB] = centerB.x;
+			m_actorPhysics.m_positionY[slotB] = centerB.y;
 
 			actorA->OnCollide(actorB);
 			actorB->OnCollide(actorA);
@@ -211,6 +540,28 @@ void Map::CollideActor(Actor* actorA, Actor* actorB)
 	}
 }
 
+bool Map::CanActorsCollide(Actor const* actorA, Actor const* actorB) const
+{
+	int slotA = (int)actorA->m_handle.GetIndex();
+	int slotB = (int)actorB->m_handle.GetIndex();
+	if (!m_actorPhysics.HasFlags(slotA, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS) || !m_actorPhysics.HasFlags(slotB, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS))
+	{
+		return false;
+	}
+	// projectile vs. projectile and projectile vs. owner
+	// same owner
+	if (actorA->m_owner == actorB->m_owner && actorA->m_owner.IsValid())
+	{
+		return false;
+	}
+	// A owns B / B owns A
+	if (actorA->m_owner == actorB->m_handle || actorB->m_owner == actorA->m_handle)
+	{
+		return false;
+	}
+	return true;
+}
+
 void Map::CollideActorsWithMap()
 {
 	// If it is static no need to collide with map?
@@ -227,15 +578,17 @@ void Map::CollideActorsWithMap()
 
 void Map::CollideActorWithMap(Actor* actor)
 {
-	if (!actor->m_definition->m_collision.m_collidesWithWorld)
+	int slot = (int)actor->m_handle.GetIndex();
+	if (!m_actorPhysics.HasFlags(slot, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_WORLD))
 	{
 		return;
 	}
 
-	// Collide with Grid
-	IntVec2 currentCoords = GetCoordsForWorldPos(actor->m_position.x, actor->m_position.y);
+	// Collide with Grid, nothing to do in open floor
+	bool isClearOfWalls = IsPositionClearOfWalls(Vec2(m_actorPhysics.m_positionX[slot], m_actorPhysics.m_positionY[slot]), m_actorPhysics.m_radius[slot]);
+	IntVec2 currentCoords = GetCoordsForWorldPos(m_actorPhysics.m_positionX[slot], m_actorPhysics.m_positionY[slot]);
 	IntVec2 directions[8] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0), IntVec2(1,1), IntVec2(-1,1), IntVec2(-1,-1), IntVec2(1,-1) };
-	for (int i = 0; i < 8; ++i)
+	for (int i = 0; i < 8 && !isClearOfWalls; ++i)
 	{
 		IntVec2 tileCoords = currentCoords + directions[i];
 
@@ -246,12 +599,12 @@ void Map::CollideActorWithMap(Actor* actor)
 		Vec2 mins = Vec2(static_cast<float>(tileCoords.x), static_cast<float>(tileCoords.y));
 		AABB2 tileBounds = AABB2(mins, mins+ Vec2::ONE);
 
-		Vec2 actorCenter = Vec2(actor->m_position.x, actor->m_position.y);
-		bool isPushed = PushDiscOutOfFixedAABB2D(actorCenter, actor->m_definition->m_collision.m_physicsRadius, tileBounds);
+		Vec2 actorCenter = Vec2(m_actorPhysics.m_positionX[slot], m_actorPhysics.m_positionY[slot]);
+		bool isPushed = PushDiscOutOfFixedAABB2D(actorCenter, m_actorPhysics.m_radius[slot], tileBounds);
 		if (isPushed)
 		{
-			actor->m_position.x = actorCenter.x;
-			actor->m_position.y = actorCenter.y;
+			m_actorPhysics.m_positionX[slot] = actorCenter.x;
+			m_actorPhysics.m_positionY[slot] = actorCenter.y;
 
 			actor->OnCollide(nullptr);
 		}
@@ -262,21 +615,34 @@ void Map::CollideActorWithMap(Actor* actor)
 	float constexpr CEILINGZ = 1.f;
 	float constexpr FLOORZ = 0.f;
 
-	float actorTopZ = actor->m_position.z + actor->m_definition->m_collision.m_physicsHeight;
+	float actorTopZ = m_actorPhysics.m_positionZ[slot] + m_actorPhysics.m_height[slot];
 	if (actorTopZ > CEILINGZ)
 	{
-		actor->m_position.z -= (actorTopZ - CEILINGZ);
+		m_actorPhysics.m_positionZ[slot] -= (actorTopZ - CEILINGZ);
 		actor->OnCollide(nullptr);
 	}
 
-	float actorBottomZ = actor->m_position.z;
+	float actorBottomZ = m_actorPhysics.m_positionZ[slot];
 	if (actorBottomZ < FLOORZ)
 	{
-		actor->m_position.z += (FLOORZ - actorBottomZ);
+		m_actorPhysics.m_positionZ[slot] += (FLOORZ - actorBottomZ);
 		actor->OnCollide(nullptr);
 	}
 }
 
+void Map::CopyActorPhysicsToActors()
+{
+	for (int actorIndex = 0; actorIndex < (int)m_allActors.size(); ++actorIndex)
+	{
+		Actor* actor = m_allActors[actorIndex];
+		if (actor != nullptr)
+		{
+			actor->m_position = m_actorPhysics.GetPosition(actorIndex);
+		}
+	}
+	m_isActorRaycastGridDirty = true; // collisions moved them again
+}
+
 void Map::CheckAndSpawnPlayers()
 {
 	for (int playerIndex = 0; playerIndex < (int)g_theGame->m_players.size(); ++playerIndex)
@@ -288,132 +654,774 @@ void Map::CheckAndSpawnPlayers()
 			SpawnPlayer(playerIndex);
 		}
 	}
-	// No possessed actor, wrong map
-	// A Known BUG, when player possess other actor, and marine dead, it will not spawn new marine for player
-}
+	// No possessed actor, wrong map
+	// A Known BUG, when player possess other actor, and marine dead, it will not spawn new marine for player
+}
+
+void Map::UpdateNavGrids()
+{
+	// Exposure and flow only depend on the tiles the players stand on, rebuild when those change
+	std::vector<IntVec2> playerTiles;
+	GetPlayerNavKey(playerTiles);
+	m_navFrame++;
+
+	if (m_navSectors.IsBuilt())
+	{
+		// Sector nav: portal costs follow the players, fine fields are built for the sectors AI actors are in
+		if (!m_hasNavKey || playerTiles != m_navKey)
+		{
+			UpdateNavSectorCosts(playerTiles);
+			m_navKey = playerTiles;
+			m_hasNavKey = true;
+		}
+		m_navKeyFrame = m_navFrame;
+		BuildActiveNavSectors();
+		return;
+	}
+
+	// The first fields are built right away, so AI never reads an empty field
+	if (m_navUpdateMode != NavUpdateMode::BLOCKING && m_hasNavKey)
+	{
+		UpdateNavGridsDeferred(playerTiles);
+		return;
+	}
+	if (m_hasNavKey && playerTiles == m_navKey)
+	{
+		m_navKeyFrame = m_navFrame;
+		return;
+	}
+
+	m_navKey = playerTiles;
+	m_hasNavKey = true;
+	m_navKeyFrame = m_navFrame;
+	m_flowFieldVersion++;
+	if (m_navFieldCache.Lookup(m_navKey, *m_exposureMap, GetNavCacheFlowField()))
+	{
+		return;
+	}
+	UpdateExposureMap(m_navKey, *m_exposureMap, g_theWorkerPool);
+	UpdateFlowField(*m_exposureMap, *m_flowField, g_theWorkerPool);
+	m_navFieldCache.Store(m_navKey, *m_exposureMap, GetNavCacheFlowField());
+}
+
+void Map::UpdateNavGridsDeferred(std::vector<IntVec2> const& playerTiles)
+{
+	if (m_navUpdateMode == NavUpdateMode::TIME_SLICED && m_navBuildStage != NavBuildStage::IDLE)
+	{
+		StepNavBuild();
+	}
+
+	// A finished build's back buffer becomes the front buffer, AI reads it from the next actor update on
+	if (TryCollectNavBuild())
+	{
+		std::swap(m_exposureMap, m_backExposureMap);
+		std::swap(m_flowField, m_backFlowField);
+		m_navKey = m_navJobKey;
+		m_navKeyFrame = m_navJobFrame;
+		m_flowFieldVersion++;
+		m_navFieldCache.Store(m_navKey, *m_exposureMap, GetNavCacheFlowField());
+	}
+
+	if (playerTiles == m_navKey)
+	{
+		m_navKeyFrame = m_navFrame;
+		return;
+	}
+	if (IsNavBuildBusy())
+	{
+		return; // the next build starts from the player tiles of the frame this one is collected in
+	}
+	if (m_navFieldCache.Lookup(playerTiles, *m_exposureMap, GetNavCacheFlowField()))
+	{
+		m_navKey = playerTiles;
+		m_navKeyFrame = m_navFrame;
+		m_flowFieldVersion++;
+		return;
+	}
+
+	// Snapshot of the player tiles, the build only touches the back buffers and its own scratch
+	m_navJobKey = playerTiles;
+	m_navJobFrame = m_navFrame;
+	StartNavBuild();
+}
+
+bool Map::IsNavBuildBusy() const
+{
+	if (m_navUpdateMode == NavUpdateMode::TIME_SLICED)
+	{
+		return m_navBuildStage != NavBuildStage::IDLE;
+	}
+	return m_navJob.IsBusy();
+}
+
+TileDirectionGrid* Map::GetNavCacheFlowField() const
+{
+	// Lazy fields are re-evaluated after every version bump, a cached copy would never be read
+	return m_isFlowFieldLazy ? nullptr : m_flowField;
+}
+
+bool Map::TryCollectNavBuild()
+{
+	if (m_navUpdateMode == NavUpdateMode::TIME_SLICED)
+	{
+		if (m_navBuildStage != NavBuildStage::DONE)
+		{
+			return false;
+		}
+		m_navBuildStage = NavBuildStage::IDLE;
+		return true;
+	}
+	return m_navJob.TryCollect();
+}
+
+void Map::StartNavBuild()
+{
+	if (m_navUpdateMode == NavUpdateMode::TIME_SLICED)
+	{
+		SetNavBuildStage(NavBuildStage::CLEAR_EXPOSURE); // first slice runs next frame
+		return;
+	}
+	m_navJob.Start([this]()
+		{
+			UpdateExposureMap(m_navJobKey, *m_backExposureMap, nullptr);
+			UpdateFlowField(*m_backExposureMap, *m_backFlowField, nullptr);
+		});
+}
+
+void Map::StepNavBuild()
+{
+	// At least one unit of work per frame, then more until the budget is spent
+	double endTime = GetCurrentTimeSeconds() + static_cast<double>(m_navSliceMicroseconds) * 0.000001;
+	do
+	{
+		RunNavBuildUnit();
+	} while (m_navBuildStage != NavBuildStage::DONE && GetCurrentTimeSeconds() < endTime);
+}
+
+void Map::RunNavBuildUnit()
+{
+	// Same steps as UpdateExposureMap and UpdateFlowField, a band of rows, a visibility task or a few spread tiles at a time
+	TileDistanceGrid& exposureMap = *m_backExposureMap;
+	int beginTileY = m_navBuildCursor;
+	int endTileY = (beginTileY + EXPOSURE_ROWS_PER_TASK < m_dimensions.y) ? beginTileY + EXPOSURE_ROWS_PER_TASK : m_dimensions.y;
+	switch (m_navBuildStage)
+	{
+	case NavBuildStage::CLEAR_EXPOSURE:
+		ClearExposureRows(m_navJobKey, exposureMap, beginTileY, endTileY);
+		FinishNavBuildRows(endTileY, NavBuildStage::MARK_EXPOSED);
+		break;
+	case NavBuildStage::MARK_EXPOSED:
+		if (m_navBuildCursor < m_navBuildNumTasks)
+		{
+			MarkExposedTilesTask(m_navJobKey, m_navBuildCursor);
+			WriteExposedTiles(exposureMap, m_navBuildCursor);
+			m_navBuildCursor++;
+		}
+		if (m_navBuildCursor >= m_navBuildNumTasks)
+		{
+			SetNavBuildStage(NavBuildStage::SPREAD_EXPOSED);
+		}
+		break;
+	case NavBuildStage::SPREAD_EXPOSED:
+		if (m_navBuildSpread.Step(NAV_SLICE_SPREAD_TILES))
+		{
+			SetNavBuildStage(NavBuildStage::MARK_HIDDEN);
+		}
+		break;
+	case NavBuildStage::MARK_HIDDEN:
+		MarkHiddenRows(exposureMap, beginTileY, endTileY);
+		FinishNavBuildRows(endTileY, NavBuildStage::SPREAD_HIDDEN);
+		break;
+	case NavBuildStage::SPREAD_HIDDEN:
+		if (m_navBuildSpread.Step(NAV_SLICE_SPREAD_TILES))
+		{
+			SetNavBuildStage(m_isFlowFieldLazy ? NavBuildStage::DONE : NavBuildStage::LOAD_FLOW);
+		}
+		break;
+	case NavBuildStage::LOAD_FLOW:
+		m_flowFieldBuilder.LoadDistanceRows(exposureMap, beginTileY, endTileY);
+		FinishNavBuildRows(endTileY, NavBuildStage::BUILD_FLOW);
+		break;
+	case NavBuildStage::BUILD_FLOW:
+		m_flowFieldBuilder.BuildFlowRows(beginTileY, endTileY, *m_backFlowField);
+		FinishNavBuildRows(endTileY, NavBuildStage::DONE);
+		break;
+	default:
+		break;
+	}
+}
+
+void Map::FinishNavBuildRows(int endTileY, NavBuildStage nextStage)
+{
+	m_navBuildCursor = endTileY;
+	if (m_navBuildCursor >= m_dimensions.y)
+	{
+		SetNavBuildStage(nextStage);
+	}
+}
+
+void Map::SetNavBuildStage(NavBuildStage stage)
+{
+	m_navBuildStage = stage;
+	m_navBuildCursor = 0;
+	if (stage == NavBuildStage::MARK_EXPOSED)
+	{
+		m_navBuildNumTasks = BeginMarkExposedTiles(m_navJobKey);
+	}
+	else if (stage == NavBuildStage::SPREAD_EXPOSED)
+	{
+		m_navBuildSpread.Begin(*m_backExposureMap, UNEXPOSED_VALUE, 1.f, m_unreachableTiles);
+	}
+	else if (stage == NavBuildStage::SPREAD_HIDDEN)
+	{
+		m_navBuildSpread.Begin(*m_backExposureMap, UNEXPOSED_VALUE + 1.f, -1.f, m_unreachableTiles);
+	}
+}
+
+int Map::GetNavAgeInFrames() const
+{
+	return m_navFrame - m_navKeyFrame;
+}
+
+void Map::GetPlayerNavKey(std::vector<IntVec2>& out_playerTiles) const
+{
+	out_playerTiles.clear();
+	for (int playerIndex = 0; playerIndex < (int)g_theGame->m_players.size(); ++playerIndex)
+	{
+		Player* player = g_theGame->m_players[playerIndex];
+		Actor* controlledActor = player->GetActor();
+
+		if (controlledActor != nullptr)
+		{
+			Vec3 playerPosition = controlledActor->m_position;
+			out_playerTiles.push_back(GetCoordsForWorldPos(playerPosition.x, playerPosition.y));
+		}
+	}
+
+	// Same tiles in any player order give the same fields
+	std::sort(out_playerTiles.begin(), out_playerTiles.end(), [](IntVec2 const& a, IntVec2 const& b)
+		{
+			return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+		});
+}
+
+void Map::UpdateExposureMap(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, WorkerPool* workerPool)
+{
+	// Set initial value for exposure map, then mark the tiles each player can see
+	ClearExposureRows(playerTiles, exposureMap, 0, m_dimensions.y);
+	MarkExposedTiles(playerTiles, exposureMap, workerPool);
+
+	//SpreadDistanceMapHeat(exposureMap, UNEXPOSED_VALUE, 1.f);
+	SpreadDistanceMapHeatOnReachableMap(exposureMap, UNEXPOSED_VALUE, 1.f);
+
+	// Enemy Will Run to the farthest tile
+	// Reverse spread
+	MarkHiddenRows(exposureMap, 0, m_dimensions.y);
+
+	//SpreadDistanceMapHeat(exposureMap, UNEXPOSED_VALUE + 1.f, -1.f);
+	SpreadDistanceMapHeatOnReachableMap(exposureMap, UNEXPOSED_VALUE + 1.f, -1.f);
+}
+
+void Map::ClearExposureRows(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, int beginTileY, int endTileY) const
+{
+	// Use the reachable map once there is a player to hide from
+	bool hasPlayers = !playerTiles.empty();
+	for (int tileY = beginTileY; tileY < endTileY; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			bool isSpecial = hasPlayers && m_unreachableTiles.IsSet(tileX, tileY);
+			exposureMap.SetValueAtIndex(tileX + tileY * m_dimensions.x, isSpecial ? SPECIAL_VALUE_POS : UNEXPOSED_VALUE);
+		}
+	}
+}
+
+void Map::MarkHiddenRows(TileDistanceGrid& exposureMap, int beginTileY, int endTileY) const
+{
+	// Tiles the first spread did not reach are unexposed, the reverse spread starts from the exposed tiles next to them
+	for (int tileIndex = beginTileY * m_dimensions.x; tileIndex < endTileY * m_dimensions.x; ++tileIndex)
+	{
+		if (exposureMap.GetValueAtIndex(tileIndex) == UNEXPOSED_VALUE)
+		{
+			exposureMap.SetValueAtIndex(tileIndex, SPECIAL_VALUE_NEG);
+		}
+	}
+}
+
+void Map::MarkExposedTiles(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, WorkerPool* workerPool)
+{
+	// Every visibility task lists the tiles it sees, the lists are then written into the exposure map on this thread
+	int numTasks = BeginMarkExposedTiles(playerTiles);
+	if (numTasks == 0)
+	{
+		return;
+	}
+
+	RunParallelFor(workerPool, numTasks, 1, [&](int beginTask, int endTask)
+		{
+			for (int taskIndex = beginTask; taskIndex < endTask; ++taskIndex)
+			{
+				MarkExposedTilesTask(playerTiles, taskIndex);
+			}
+		});
+
+	for (int taskIndex = 0; taskIndex < numTasks; ++taskIndex)
+	{
+		WriteExposedTiles(exposureMap, taskIndex);
+	}
+}
+
+int Map::BeginMarkExposedTiles(std::vector<IntVec2> const& playerTiles)
+{
+	int numPlayers = (int)playerTiles.size();
+	int numTasks = 0;
+	if (m_exposureVisibilityMode == ExposureVisibilityMode::SHADOWCAST)
+	{
+		numTasks = numPlayers * NUM_FIELD_OF_VIEW_QUADRANTS;
+	}
+	else
+	{
+		int numBands = (m_dimensions.y + EXPOSURE_ROWS_PER_TASK - 1) / EXPOSURE_ROWS_PER_TASK;
+		numTasks = numPlayers * numBands;
+	}
+
+	// Lists keep their capacity between builds, each is cleared by the task that owns it
+	if ((int)m_exposedTaskTiles.size() < numTasks)
+	{
+		m_exposedTaskTiles.resize(numTasks);
+	}
+	return numTasks;
+}
+
+void Map::MarkExposedTilesTask(std::vector<IntVec2> const& playerTiles, int taskIndex)
+{
+	m_exposedTaskTiles[taskIndex].clear();
+	if (m_exposureVisibilityMode == ExposureVisibilityMode::SHADOWCAST)
+	{
+		MarkExposedTilesShadowcast(playerTiles, taskIndex);
+	}
+	else
+	{
+		MarkExposedTilesRaycast(playerTiles, taskIndex);
+	}
+}
+
+void Map::MarkExposedTilesRaycast(std::vector<IntVec2> const& playerTiles, int taskIndex)
+{
+	// One task per player and band of rows
+	int numBands = (m_dimensions.y + EXPOSURE_ROWS_PER_TASK - 1) / EXPOSURE_ROWS_PER_TASK;
+	int playerIndex = taskIndex / numBands;
+	int beginTileY = (taskIndex % numBands) * EXPOSURE_ROWS_PER_TASK;
+	int endTileY = (beginTileY + EXPOSURE_ROWS_PER_TASK < m_dimensions.y) ? beginTileY + EXPOSURE_ROWS_PER_TASK : m_dimensions.y;
+	std::vector<IntVec2>& visibleTiles = m_exposedTaskTiles[taskIndex];
+	IntVec2 const& playerTile = playerTiles[playerIndex];
+	Vec2 playerPos = GetTileCenter(playerTile.x, playerTile.y);
+
+	// Tiles without a baked PVS entry get the same ray as RaycastTileToTile, traced together at the end of the band
+	VoxelRayBatch rayBatch;
+	std::vector<IntVec2> rayTiles;
+	for (int tileY = beginTileY; tileY < endTileY; ++tileY)
+	{
+		m_unreachableTiles.ForEachClearTileInRow(tileY, [&](int tileX)
+			{
+				Vec2 disp = GetTileCenter(tileX, tileY) - playerPos;
+				// Limited view range
+				if (disp.GetLength() > SIGHT_RANGE)
+				{
+					return;
+				}
+				IntVec2 tileCoords = IntVec2(tileX, tileY);
+				if (!m_tileVisibility.HasEntry(playerTile, tileCoords))
+				{
+					rayBatch.AddRay(playerPos, disp.GetNormalized(), disp.GetLength());
+					rayTiles.push_back(tileCoords);
+				}
+				else if (m_tileVisibility.IsVisible(playerTile, tileCoords))
+				{
+					// player can reach
+					visibleTiles.push_back(tileCoords);
+				}
+			});
+	}
+
+	rayBatch.Trace(m_solidTiles);
+	for (int rayIndex = 0; rayIndex < rayBatch.GetNumRays(); ++rayIndex)
+	{
+		if (!rayBatch.GetHit(rayIndex).m_didImpact)
+		{
+			visibleTiles.push_back(rayTiles[rayIndex]);
+		}
+	}
+}
+
+void Map::MarkExposedTilesShadowcast(std::vector<IntVec2> const& playerTiles, int taskIndex)
+{
+	// One task per player and quadrant, the diagonals shared by two quadrants are listed twice
+	IntVec2 const& playerTile = playerTiles[taskIndex / NUM_FIELD_OF_VIEW_QUADRANTS];
+	int quadrantIndex = taskIndex % NUM_FIELD_OF_VIEW_QUADRANTS;
+	std::vector<IntVec2>& visibleTiles = m_exposedTaskTiles[taskIndex];
+	if (quadrantIndex == 0)
+	{
+		visibleTiles.push_back(playerTile);
+	}
+	ComputeTileFieldOfViewQuadrant(m_solidTiles, playerTile, SIGHT_RANGE, quadrantIndex, visibleTiles);
+}
+
+void Map::WriteExposedTiles(TileDistanceGrid& exposureMap, int taskIndex) const
+{
+	// O(visible tiles), writing a tile twice is harmless
+	for (IntVec2 const& tileCoords : m_exposedTaskTiles[taskIndex])
+	{
+		if (!IsTileUnreachable(tileCoords.x, tileCoords.y))
+		{
+			exposureMap.SetValueAtIndex(tileCoords.x + tileCoords.y * m_dimensions.x, EXPOSED_VALUE);
+		}
+	}
+}
+
+void Map::UpdateFlowField(TileDistanceGrid const& exposureMap, TileDirectionGrid& flowField, WorkerPool* workerPool)
+{
+	if (m_isFlowFieldLazy)
+	{
+		return; // tiles are evaluated from the front exposure map when they are sampled
+	}
+	m_flowFieldBuilder.Build(exposureMap, workerPool, flowField);
+}
+
+void Map::UpdateNavSectorCosts(std::vector<IntVec2> const& playerTiles)
+{
+	// Exposed tiles, O(visible tiles)
+	for (IntVec2 const& tileCoords : m_exposedTileList)
+	{
+		m_exposedTiles.Set(tileCoords.x, tileCoords.y, false);
+	}
+	m_exposedTileList.clear();
+	std::vector<IntVec2> visibleTiles;
+	for (IntVec2 const& playerTile : playerTiles)
+	{
+		visibleTiles.clear();
+		ComputeTileFieldOfView(m_solidTiles, playerTile, SIGHT_RANGE, visibleTiles);
+		for (IntVec2 const& tileCoords : visibleTiles)
+		{
+			if (!m_unreachableTiles.IsSet(tileCoords.x, tileCoords.y) && !m_exposedTiles.IsSet(tileCoords.x, tileCoords.y))
+			{
+				m_exposedTiles.Set(tileCoords.x, tileCoords.y, true);
+				m_exposedTileList.push_back(tileCoords);
+			}
+		}
+	}
+
+	// Portal seeds: a sector nobody sees is unexposed everywhere, so its portals start at 0.
+	// Sectors with exposed tiles walk from their unexposed tiles to the portal centers
+	int numPortals = m_navSectors.GetNumPortals();
+	std::vector<float> portalSeedCosts(numPortals, -1.f);
+	std::vector<unsigned char> isSectorExposed(m_navSectors.GetNumSectors(), 0);
+	for (IntVec2 const& tileCoords : m_exposedTileList)
+	{
+		isSectorExposed[m_navSectors.GetSectorIndex(tileCoords.x, tileCoords.y)] = 1;
+	}
+	std::vector<IntVec2> seedTiles;
+	std::vector<int> distances;
+	for (int sectorIndex = 0; sectorIndex < m_navSectors.GetNumSectors(); ++sectorIndex)
+	{
+		IntVec2 minTile;
+		IntVec2 maxTile;
+		m_navSectors.GetSectorBounds(sectorIndex, minTile, maxTile);
+		if (isSectorExposed[sectorIndex])
+		{
+			seedTiles.clear();
+			for (int tileY = minTile.y; tileY <= maxTile.y; ++tileY)
+			{
+				for (int tileX = minTile.x; tileX <= maxTile.x; ++tileX)
+				{
+					if (!m_unreachableTiles.IsSet(tileX, tileY) && !m_exposedTiles.IsSet(tileX, tileY))
+					{
+						seedTiles.push_back(IntVec2(tileX, tileY));
+					}
+				}
+			}
+			m_navSectors.ComputeSectorDistances(sectorIndex, seedTiles, distances);
+		}
+
+		int const* portalsBegin = nullptr;
+		int const* portalsEnd = nullptr;
+		m_navSectors.GetSectorPortals(sectorIndex, portalsBegin, portalsEnd);
+		for (int const* portalIndex = portalsBegin; portalIndex != portalsEnd; ++portalIndex)
+		{
+			float seedCost = 0.f;
+			if (isSectorExposed[sectorIndex])
+			{
+				IntVec2 centerTile = m_navSectors.GetPortal(*portalIndex).GetCenterTile(sectorIndex);
+				int distance = distances[(centerTile.x - minTile.x) + (centerTile.y - minTile.y) * (maxTile.x - minTile.x + 1)];
+				if (distance < 0)
+				{
+					continue;
+				}
+				seedCost = static_cast<float>(distance);
+			}
+			if (portalSeedCosts[*portalIndex] < 0.f || seedCost < portalSeedCosts[*portalIndex])
+			{
+				portalSeedCosts[*portalIndex] = seedCost;
+			}
+		}
+	}
+	m_navSectors.SolvePortalCosts(portalSeedCosts, m_navPortalCosts);
 
-void Map::UpdateNavGrids()
-{
-	UpdateExposureMap();
-	UpdateFlowField();
+	// Every fine field is out of date now
+	for (int sectorIndex : m_builtNavSectors)
+	{
+		ResetNavSector(sectorIndex);
+	}
+	m_builtNavSectors.clear();
 }
 
-void Map::UpdateExposureMap()
+void Map::BuildActiveNavSectors()
 {
-	std::vector<Vec2> playerPositions;
-
-	// Get Player Positions
-	for (int playerIndex = 0; playerIndex < (int)g_theGame->m_players.size(); ++playerIndex)
+	// Every sector the AI actors sample the flow field from, the 2x2 tiles around them
+	for (Actor* actor : m_liveActors)
 	{
-		Player* player = g_theGame->m_players[playerIndex];
-		Actor* controlledActor = player->GetActor();
-
-		if (controlledActor != nullptr)
+		if (!IsAlive(actor) || actor->m_controller == nullptr || !actor->m_controller->IsAIController())
 		{
-			Vec3 playerPosition = controlledActor->m_position;
-			playerPositions.push_back(Vec2(playerPosition.x, playerPosition.y));
+			continue;
 		}
-	}
-
-	// Cast rays from each player to each cell, set initial value for exposure map
-	m_exposureMap->SetAllValues(UNEXPOSED_VALUE);
-	for (Vec2 const& playerPos : playerPositions)
-	{
-		for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+		IntVec2 bottomLeftTileCoords = IntVec2(RoundDownToInt(actor->m_position.x - 0.5f), RoundDownToInt(actor->m_position.y - 0.5f));
+		for (int offsetY = 0; offsetY < 2; ++offsetY)
 		{
-			for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+			for (int offsetX = 0; offsetX < 2; ++offsetX)
 			{
-				if (IsTileUnreachable(tileX, tileY)) // Use the reachable map
+				int tileX = bottomLeftTileCoords.x + offsetX;
+				int tileY = bottomLeftTileCoords.y + offsetY;
+				if (!AreCoordsInBounds(tileX, tileY))
 				{
-					m_exposureMap->SetValueAtCoords(IntVec2(tileX, tileY), SPECIAL_VALUE_POS);
 					continue;
 				}
-
-				Vec2 rayEnd = GetTileCenter(tileX, tileY);
-				Vec2 disp = rayEnd - playerPos;
-				RaycastResult2D result = FastVoxelRaycast(playerPos, disp.GetNormalized(), disp.GetLength());
-				// Limited view range
-				if (!result.m_didImpact && result.m_impactDist <= SIGHT_RANGE)
+				int sectorIndex = m_navSectors.GetSectorIndex(tileX, tileY);
+				if (!m_isNavSectorBuilt[sectorIndex])
 				{
-					// player can reach
-					m_exposureMap->SetValueAtCoords(IntVec2(tileX, tileY), EXPOSED_VALUE);
+					BuildNavSector(sectorIndex);
 				}
 			}
 		}
 	}
+}
 
-	//SpreadDistanceMapHeat(*m_exposureMap, UNEXPOSED_VALUE, 1.f);
-	SpreadDistanceMapHeatOnReachableMap(*m_exposureMap, UNEXPOSED_VALUE, 1.f);
+void Map::BuildNavSector(int sectorIndex)
+{
+	// Same values as the full exposure map inside the sector: unreachable tiles are special, unexposed tiles are 0 next to an
+	// exposed tile and -1 otherwise, exposed tiles are the walking distance to the nearest unexposed tile. The walk covers
+	// the sector plus a one tile ring, and reachable exposed ring tiles on a portal start at the portal's coarse cost.
+	// Steps and portal costs are whole numbers, so the walk goes level by level like the heat spread, in the map's scratch.
+	IntVec2 minTile;
+	IntVec2 maxTile;
+	m_navSectors.GetSectorBounds(sectorIndex, minTile, maxTile);
+	IntVec2 localOrigin = IntVec2(minTile.x - 1, minTile.y - 1);
+	int localWidth = maxTile.x - minTile.x + 3;
+	int localHeight = maxTile.y - minTile.y + 3;
+	int numLocalTiles = localWidth * localHeight;
+	IntVec2 directions[4] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0) };
 
-	// Enemy Will Run to the farthest tile
-	// Reverse spread
-	int numTiles = m_exposureMap->GetNumTiles();
-	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+	std::vector<float>& values = m_navSectorValues;
+	std::vector<int>& distances = m_navSectorDistances;
+	std::vector<int>& currentLevelTiles = m_navSectorCurrentLevelTiles;
+	std::vector<int>& nextLevelTiles = m_navSectorNextLevelTiles;
+	std::vector<IntVec2>& portalSeeds = m_navSectorPortalSeeds; // (distance, local index)
+	std::fill(values.begin(), values.begin() + numLocalTiles, SPECIAL_VALUE_POS);
+	std::fill(distances.begin(), distances.begin() + numLocalTiles, -1);
+	currentLevelTiles.clear();
+	nextLevelTiles.clear();
+	portalSeeds.clear();
+	for (int localIndex = 0; localIndex < numLocalTiles; ++localIndex)
 	{
-		if (m_exposureMap->GetValueAtIndex(tileIndex) == UNEXPOSED_VALUE)
+		int tileX = localOrigin.x + localIndex % localWidth;
+		int tileY = localOrigin.y + localIndex / localWidth;
+		if (!AreCoordsInBounds(tileX, tileY) || m_unreachableTiles.IsSet(tileX, tileY) || m_exposedTiles.IsSet(tileX, tileY))
+		{
+			continue;
+		}
+		values[localIndex] = SPECIAL_VALUE_NEG;
+		for (int i = 0; i < 4; ++i)
 		{
-			m_exposureMap->SetValueAtIndex(tileIndex, SPECIAL_VALUE_NEG);
+			if (m_exposedTiles.IsSetSafe(tileX + directions[i].x, tileY + directions[i].y, false))
+			{
+				values[localIndex] = UNEXPOSED_VALUE;
+			}
 		}
+		distances[localIndex] = 0;
+		currentLevelTiles.push_back(localIndex);
 	}
 
-	//SpreadDistanceMapHeat(*m_exposureMap, UNEXPOSED_VALUE + 1.f, -1.f);
-	SpreadDistanceMapHeatOnReachableMap(*m_exposureMap, UNEXPOSED_VALUE + 1.f, -1.f);
-}
+	int const* portalsBegin = nullptr;
+	int const* portalsEnd = nullptr;
+	m_navSectors.GetSectorPortals(sectorIndex, portalsBegin, portalsEnd);
+	for (int const* portalIndex = portalsBegin; portalIndex != portalsEnd; ++portalIndex)
+	{
+		NavPortal const& portal = m_navSectors.GetPortal(*portalIndex);
+		float portalCost = m_navPortalCosts[*portalIndex];
+		if (portalCost < 0.f)
+		{
+			continue;
+		}
+		int otherSectorIndex = (portal.m_sectorIndexA == sectorIndex) ? portal.m_sectorIndexB : portal.m_sectorIndexA;
+		for (int crossingIndex = 0; crossingIndex < portal.m_numCrossings; ++crossingIndex)
+		{
+			IntVec2 ringTile = portal.GetCrossingTile(crossingIndex, otherSectorIndex);
+			int localIndex = (ringTile.x - localOrigin.x) + (ringTile.y - localOrigin.y) * localWidth;
+			if (!m_exposedTiles.IsSet(ringTile.x, ringTile.y))
+			{
+				continue;
+			}
+			int distance = static_cast<int>(portalCost) + abs(crossingIndex - portal.m_numCrossings / 2);
+			if (distances[localIndex] < 0 || distance < distances[localIndex])
+			{
+				distances[localIndex] = distance;
+				portalSeeds.push_back(IntVec2(distance, localIndex));
+			}
+		}
+	}
+	std::sort(portalSeeds.begin(), portalSeeds.end(), [](IntVec2 const& seedA, IntVec2 const& seedB) { return seedA.x < seedB.x; });
 
-void Map::UpdateFlowField()
-{
-	IntVec2 directions[8] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0), IntVec2(1,1), IntVec2(-1,1), IntVec2(-1,-1), IntVec2(1,-1) };
-	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	int level = 0;
+	int seedCursor = 0;
+	for (;;)
 	{
-		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		// Portal seeds join the level of their distance unless the walk got there first
+		for (; seedCursor < (int)portalSeeds.size() && portalSeeds[seedCursor].x == level; ++seedCursor)
+		{
+			if (distances[portalSeeds[seedCursor].y] == level)
+			{
+				currentLevelTiles.push_back(portalSeeds[seedCursor].y);
+			}
+		}
+		if (currentLevelTiles.empty())
 		{
-			IntVec2 flowDirection = IntVec2(0, 0);
-			float minDelta = 0; // delta = neighborValue - currentValue
+			if (seedCursor == (int)portalSeeds.size())
+			{
+				break;
+			}
+			level = portalSeeds[seedCursor].x;
+			continue;
+		}
 
-			IntVec2 currentTileCoords = IntVec2(tileX, tileY);
-			float currentTileValue = m_exposureMap->GetValueAtCoords(currentTileCoords);
-			bool isNeighborImpassable[4] = {};
+		for (int localIndex : currentLevelTiles)
+		{
+			if (distances[localIndex] != level)
+			{
+				continue; // stale entry
+			}
+			int localX = localIndex % localWidth;
+			int localY = localIndex / localWidth;
 			for (int i = 0; i < 4; ++i)
 			{
-				IntVec2 neighborTileCoords = currentTileCoords + directions[i];
-				if (IsTileUnreachable(neighborTileCoords.x, neighborTileCoords.y))
+				int neighborX = localX + directions[i].x;
+				int neighborY = localY + directions[i].y;
+				if (neighborX < 0 || neighborY < 0 || neighborX >= localWidth || neighborY >= localHeight)
 				{
-					isNeighborImpassable[i] = true;
 					continue;
 				}
-				float neighborTileValue = m_exposureMap->GetValueAtCoords(neighborTileCoords);
-				float delta = neighborTileValue - currentTileValue;
-				if (delta < minDelta)
+				int tileX = localOrigin.x + neighborX;
+				int tileY = localOrigin.y + neighborY;
+				if (!m_exposedTiles.IsSetSafe(tileX, tileY, false)) // unexposed tiles are seeds, unreachable tiles are never exposed
 				{
-					flowDirection = directions[i];
-					minDelta = delta;
+					continue;
+				}
+				int neighborIndex = neighborX + neighborY * localWidth;
+				if (distances[neighborIndex] < 0 || level + 1 < distances[neighborIndex])
+				{
+					distances[neighborIndex] = level + 1;
+					nextLevelTiles.push_back(neighborIndex);
 				}
 			}
+		}
+		currentLevelTiles.swap(nextLevelTiles);
+		nextLevelTiles.clear();
+		++level;
+	}
+	for (int localIndex = 0; localIndex < numLocalTiles; ++localIndex)
+	{
+		int tileX = localOrigin.x + localIndex % localWidth;
+		int tileY = localOrigin.y + localIndex / localWidth;
+		if (m_exposedTiles.IsSetSafe(tileX, tileY, false))
+		{
+			values[localIndex] = (distances[localIndex] >= 0) ? static_cast<float>(distances[localIndex]) : EXPOSED_VALUE;
+		}
+	}
 
-			for (int i = 4; i < 8; ++i)
+	// Flow with the same neighbour rules and tie-break as the full field
+	for (int tileY = minTile.y; tileY <= maxTile.y; ++tileY)
+	{
+		for (int tileX = minTile.x; tileX <= maxTile.x; ++tileX)
+		{
+			int tileIndex = tileX + tileY * m_dimensions.x;
+			int localIndex = (tileX - localOrigin.x) + (tileY - localOrigin.y) * localWidth;
+			unsigned char neighborMask = m_flowFieldBuilder.GetNeighborMask(tileIndex);
+			unsigned char directionCode = 0;
+			float minDelta = 0.f;
+			for (int directionIndex = 0; directionIndex < NUM_FLOW_DIRECTIONS; ++directionIndex)
 			{
-				// The Corner is not accessible
-				if (i == 4 && isNeighborImpassable[0] && isNeighborImpassable[2]) continue;
-				if (i == 5 && isNeighborImpassable[0] && isNeighborImpassable[3]) continue;
-				if (i == 6 && isNeighborImpassable[1] && isNeighborImpassable[3]) continue;
-				if (i == 7 && isNeighborImpassable[1] && isNeighborImpassable[2]) continue;
-
-				IntVec2 neighborTileCoords = currentTileCoords + directions[i];
-				if (!m_flowField->IsInBounds(neighborTileCoords))
+				if ((neighborMask & (1 << directionIndex)) == 0)
 				{
 					continue;
 				}
-				float neighborTileValue = m_exposureMap->GetValueAtCoords(neighborTileCoords);
-				float delta = neighborTileValue - currentTileValue;
+				IntVec2 offset = FlowFieldBuilder::GetDirectionOffset((unsigned char)(directionIndex + 1));
+				float delta = values[localIndex + offset.x + offset.y * localWidth] - values[localIndex];
 				if (delta < minDelta)
 				{
-					flowDirection = directions[i];
+					directionCode = (unsigned char)(directionIndex + 1);
 					minDelta = delta;
 				}
 			}
-			m_flowField->SetValueAtCoords(currentTileCoords, Vec2(flowDirection).GetNormalized());
+			m_exposureMap->SetValueAtIndex(tileIndex, values[localIndex]);
+			m_flowField->SetCode(tileX, tileY, directionCode);
+		}
+	}
+
+	m_isNavSectorBuilt[sectorIndex] = 1;
+	RefreshFlowFieldSamplerTiles(minTile, maxTile);
+	m_builtNavSectors.push_back(sectorIndex);
+}
+
+void Map::ResetNavSector(int sectorIndex)
+{
+	IntVec2 minTile;
+	IntVec2 maxTile;
+	m_navSectors.GetSectorBounds(sectorIndex, minTile, maxTile);
+	for (int tileY = minTile.y; tileY <= maxTile.y; ++tileY)
+	{
+		for (int tileX = minTile.x; tileX <= maxTile.x; ++tileX)
+		{
+			int tileIndex = tileX + tileY * m_dimensions.x;
+			m_exposureMap->SetValueAtIndex(tileIndex, m_unreachableTiles.IsSet(tileX, tileY) ? SPECIAL_VALUE_POS : SPECIAL_VALUE_NEG);
+			m_flowField->SetCode(tileX, tileY, 0);
 		}
 	}
+	m_isNavSectorBuilt[sectorIndex] = 0;
+	RefreshFlowFieldSamplerTiles(minTile, maxTile);
+}
+
+void Map::RefreshFlowFieldSamplerTiles(IntVec2 const& minTile, IntVec2 const& maxTile)
+{
+	// Only the sector's tiles changed, a sampler that is due for a full reload picks them up anyway
+	if (m_flowFieldSamplerVersion == m_flowFieldVersion)
+	{
+		m_flowFieldSampler.LoadTiles(*m_flowField, minTile, maxTile);
+	}
+}
+
+bool Map::CanTileSeeTile(IntVec2 const& fromTile, IntVec2 const& toTile) const
+{
+	if (m_tileVisibility.HasEntry(fromTile, toTile))
+	{
+		return m_tileVisibility.IsVisible(fromTile, toTile);
+	}
+	return RaycastTileToTile(fromTile, toTile);
+}
+
+bool Map::RaycastTileToTile(IntVec2 const& fromTile, IntVec2 const& toTile) const
+{
+	Vec2 rayStart = GetTileCenter(fromTile.x, fromTile.y);
+	Vec2 disp = GetTileCenter(toTile.x, toTile.y) - rayStart;
+	RaycastResult2D result = FastVoxelRaycast(rayStart, disp.GetNormalized(), disp.GetLength());
+	return !result.m_didImpact;
 }
 
 RaycastResult2D Map::FastVoxelRaycast(Vec2 rayStart, Vec2 rayForwardNormal, float rayLength) const
@@ -456,7 +1464,7 @@ RaycastResult2D Map::FastVoxelRaycast(Vec2 rayStart, Vec2 rayForwardNormal, floa
 				return raycastResult;
 			}
 			tileX += tileStepDirectionX;
-			if (IsTileSolid(tileX, tileY))
+			if (m_solidTiles.IsSet(tileX, tileY)) // the walk starts inside the map and stops at the solid border
 			{
 				raycastResult.m_didImpact = true;
 				raycastResult.m_impactDist = fwdDistAtNextXCrossing;
@@ -474,7 +1482,7 @@ RaycastResult2D Map::FastVoxelRaycast(Vec2 rayStart, Vec2 rayForwardNormal, floa
 				return raycastResult;
 			}
 			tileY += tileStepDirectionY;
-			if (IsTileSolid(tileX, tileY))
+			if (m_solidTiles.IsSet(tileX, tileY))
 			{
 				raycastResult.m_didImpact = true;
 				raycastResult.m_impactDist = fwdDistAtNextYCrossing;
@@ -487,128 +1495,121 @@ RaycastResult2D Map::FastVoxelRaycast(Vec2 rayStart, Vec2 rayForwardNormal, floa
 	}
 }
 
-void Map::SpreadDistanceMapHeat(TileHeatMap& distanceMap, float startSearchValue, float heatSpreadStep /*= 1.f*/)
+void Map::FastVoxelRaycastSegments(std::vector<Vec2> const& rayStarts, std::vector<Vec2> const& rayEnds, std::vector<RaycastResult2D>& out_results) const
 {
-	// Normally the spread step is +1, and Increasing Heat
-	// Already set values, just do heat spreading
-	IntVec2 const dimensions = distanceMap.m_dimensions;
-	IntVec2 directions[4] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0) };
-
-	bool isHeatIncreasing = heatSpreadStep > 0.f;
-
-	float currentSearchValue = startSearchValue;
-
-	bool isHeatSpreading = true;
-
-	while (isHeatSpreading)
+	VoxelRayBatch rayBatch;
+	int numRays = (int)rayStarts.size();
+	out_results.assign(numRays, RaycastResult2D());
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
 	{
-		isHeatSpreading = false;
+		Vec2 disp = rayEnds[rayIndex] - rayStarts[rayIndex];
+		RaycastResult2D& raycastResult = out_results[rayIndex];
+		raycastResult.m_ray.m_startPos = rayStarts[rayIndex];
+		raycastResult.m_ray.m_fwdNormal = disp.GetNormalized();
+		raycastResult.m_ray.m_maxLength = disp.GetLength();
+		rayBatch.AddRay(raycastResult.m_ray.m_startPos, raycastResult.m_ray.m_fwdNormal, raycastResult.m_ray.m_maxLength);
+	}
 
-		for (int tileY = 0; tileY < dimensions.y; ++tileY)
+	rayBatch.Trace(m_solidTiles);
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		VoxelRayHit const& hit = rayBatch.GetHit(rayIndex);
+		RaycastResult2D& raycastResult = out_results[rayIndex];
+		raycastResult.m_didImpact = hit.m_didImpact;
+		raycastResult.m_impactDist = hit.m_impactDist;
+		if (hit.m_isStartInside)
 		{
-			for (int tileX = 0; tileX < dimensions.x; ++tileX)
-			{
-				IntVec2 const currentTileCoords = IntVec2(tileX, tileY);
-				float currentTileValue = distanceMap.GetValueAtCoords(currentTileCoords);
-				if (currentTileValue == currentSearchValue)
-				{
-					isHeatSpreading = true; // or on neighbor value changed, one more round of search
-					for (int i = 0; i < 4; ++i) // four directions
-					{
-						IntVec2 neighborTileCoords = currentTileCoords + directions[i];
-						if (!distanceMap.IsInBounds(neighborTileCoords))
-						{
-							continue;
-						}
-						if (IsTileSolid(neighborTileCoords.x, neighborTileCoords.y))
-						{
-							continue;
-						}
-						float neighborTileValue = distanceMap.GetValueAtCoords(neighborTileCoords);
-						if (isHeatIncreasing && neighborTileValue <= (currentSearchValue + heatSpreadStep))
-						{
-							continue;
-						}
-						if (!isHeatIncreasing && neighborTileValue >= (currentSearchValue + heatSpreadStep))
-						{
-							continue;
-						}
-						distanceMap.SetValueAtCoords(neighborTileCoords, currentSearchValue + heatSpreadStep);
-					}
-				}
-			}
+			raycastResult.m_impactPos = raycastResult.m_ray.m_startPos;
+			raycastResult.m_impactNormal = -raycastResult.m_ray.m_fwdNormal;
+		}
+		else if (hit.m_didImpact)
+		{
+			raycastResult.m_impactPos = raycastResult.m_ray.m_startPos + raycastResult.m_impactDist * raycastResult.m_ray.m_fwdNormal;
+			raycastResult.m_impactNormal = hit.m_impactNormal;
 		}
-		currentSearchValue += heatSpreadStep;
 	}
 }
 
-void Map::SpreadDistanceMapHeatOnReachableMap(TileHeatMap& distanceMap, float startSearchValue, float heatSpreadStep /*= 1.f*/)
+void Map::SpreadDistanceMapHeat(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep /*= 1.f*/) const
 {
 	// Normally the spread step is +1, and Increasing Heat
 	// Already set values, just do heat spreading
-	IntVec2 const dimensions = distanceMap.m_dimensions;
-	IntVec2 directions[4] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0) };
+	SpreadDistanceMapHeatThroughTiles(distanceMap, startSearchValue, heatSpreadStep, m_solidTiles);
+}
 
-	bool isHeatIncreasing = heatSpreadStep > 0.f;
+void Map::SpreadDistanceMapHeatOnReachableMap(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep /*= 1.f*/) const
+{
+	SpreadDistanceMapHeatThroughTiles(distanceMap, startSearchValue, heatSpreadStep, m_unreachableTiles);
+}
 
-	float currentSearchValue = startSearchValue;
+void Map::SpreadDistanceMapHeatThroughTiles(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep, TileBitGrid const& blockedTiles) const
+{
+	// Bucketed spread, run to completion in one go
+	TileHeatSpread spread;
+	spread.Begin(distanceMap, startSearchValue, heatSpreadStep, blockedTiles);
+	while (!spread.Step(distanceMap.GetNumTiles()))
+	{
+	}
+}
 
-	bool isHeatSpreading = true;
+bool Map::IsTileUnreachable(int tileX, int tileY) const
+{
+	return m_unreachableTiles.IsSetSafe(tileX, tileY, true);
+}
 
-	while (isHeatSpreading)
-	{
-		isHeatSpreading = false;
+int Map::GetTileRegion(int tileX, int tileY) const
+{
+	return m_tileRegions.GetRegion(tileX, tileY);
+}
 
-		for (int tileY = 0; tileY < dimensions.y; ++tileY)
-		{
-			for (int tileX = 0; tileX < dimensions.x; ++tileX)
-			{
-				IntVec2 const currentTileCoords = IntVec2(tileX, tileY);
-				float currentTileValue = distanceMap.GetValueAtCoords(currentTileCoords);
-				if (currentTileValue == currentSearchValue)
-				{
-					isHeatSpreading = true; // or on neighbor value changed, one more round of search
-					for (int i = 0; i < 4; ++i) // four directions
-					{
-						IntVec2 neighborTileCoords = currentTileCoords + directions[i];
-						if (!distanceMap.IsInBounds(neighborTileCoords))
-						{
-							continue;
-						}
-						if (IsTileUnreachable(neighborTileCoords.x, neighborTileCoords.y))
-						{
-							continue;
-						}
-						float neighborTileValue = distanceMap.GetValueAtCoords(neighborTileCoords);
-						if (isHeatIncreasing && neighborTileValue <= (currentSearchValue + heatSpreadStep))
-						{
-							continue;
-						}
-						if (!isHeatIncreasing && neighborTileValue >= (currentSearchValue + heatSpreadStep))
-						{
-							continue;
-						}
-						distanceMap.SetValueAtCoords(neighborTileCoords, currentSearchValue + heatSpreadStep);
-					}
-				}
-			}
-		}
-		currentSearchValue += heatSpreadStep;
+bool Map::AreTilesConnected(IntVec2 const& tileA, IntVec2 const& tileB) const
+{
+	return m_tileRegions.AreTilesConnected(tileA, tileB);
+}
+
+Vec2 Map::GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos)
+{
+	if (m_isFlowFieldLazy)
+	{
+		EvaluateFlowTilesAround(worldPos);
 	}
+	return GetBilinearInterpResultFromWorldPos(*m_flowField, worldPos);
 }
 
-bool Map::IsTileUnreachable(int tileX, int tileY) const
+void Map::EvaluateFlowTilesAround(Vec2 const& worldPos)
 {
-	IntVec2 const tileCoords = IntVec2(tileX, tileY);
-	if (!m_reachableMap->IsInBounds(tileCoords))
+	// A tile is current when its stamp matches the flow field version, every exposure change bumps the version
+	if (m_lazyFlowCountVersion != m_flowFieldVersion)
 	{
-		return true;
+		m_numLazyFlowTiles = 0;
+		m_lazyFlowCountVersion = m_flowFieldVersion;
 	}
 
-	return m_reachableMap->GetValueAtCoords(tileCoords) == UNREACHABLE_VALUE;
+	Vec2 posAtBottomLeftTileCoords = (worldPos - Vec2(0.5f, 0.5f));
+	IntVec2 bottomLeftTileCoords = IntVec2(RoundDownToInt(posAtBottomLeftTileCoords.x), RoundDownToInt(posAtBottomLeftTileCoords.y));
+	for (int tileY = bottomLeftTileCoords.y; tileY <= bottomLeftTileCoords.y + 1; ++tileY)
+	{
+		for (int tileX = bottomLeftTileCoords.x; tileX <= bottomLeftTileCoords.x + 1; ++tileX)
+		{
+			if (tileX < 0 || tileY < 0 || tileX >= m_dimensions.x || tileY >= m_dimensions.y)
+			{
+				continue; // outside the map GetSafeValueFromFlowField points back in
+			}
+			int tileIndex = tileX + tileY * m_dimensions.x;
+			if (m_flowTileVersions[tileIndex] == m_flowFieldVersion)
+			{
+				continue;
+			}
+			unsigned char directionCode = m_flowFieldBuilder.ComputeDirectionCode(*m_exposureMap, tileIndex);
+			m_flowField->SetCode(tileX, tileY, directionCode);
+			m_flowFieldSampler.SetTileDirection(tileX, tileY, FlowFieldBuilder::GetDirectionVector(directionCode));
+			m_flowTileVersions[tileIndex] = m_flowFieldVersion;
+			m_numLazyFlowTiles++;
+		}
+	}
 }
 
-Vec2 Map::GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos) const
+Vec2 Map::GetBilinearInterpResultFromWorldPos(TileDirectionGrid const& flowField, Vec2 const& worldPos) const
 {
 	Vec2 posAtBottomLeftTileCoords = (worldPos - Vec2(0.5f, 0.5f));
 	IntVec2 bottomLeftTileCoords = IntVec2(RoundDownToInt(posAtBottomLeftTileCoords.x), RoundDownToInt(posAtBottomLeftTileCoords.y));
@@ -616,10 +1617,10 @@ Vec2 Map::GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos) const
 	IntVec2 bottmRightTileCoords = bottomLeftTileCoords + IntVec2(1, 0);
 	IntVec2 topRightTileCoords = bottomLeftTileCoords + IntVec2(1, 1);
 
-	Vec2 value00 = GetSafeValueFromFlowField(bottomLeftTileCoords);
-	Vec2 value01 = GetSafeValueFromFlowField(topLeftTileCoords);
-	Vec2 value10 = GetSafeValueFromFlowField(bottmRightTileCoords);
-	Vec2 value11 = GetSafeValueFromFlowField(topRightTileCoords);
+	Vec2 value00 = GetSafeValueFromFlowField(flowField, bottomLeftTileCoords);
+	Vec2 value01 = GetSafeValueFromFlowField(flowField, topLeftTileCoords);
+	Vec2 value10 = GetSafeValueFromFlowField(flowField, bottmRightTileCoords);
+	Vec2 value11 = GetSafeValueFromFlowField(flowField, topRightTileCoords);
 
 	float xWeight = posAtBottomLeftTileCoords.x - floorf(posAtBottomLeftTileCoords.x); // 0~1
 	float yWeight = posAtBottomLeftTileCoords.y - floorf(posAtBottomLeftTileCoords.y);
@@ -632,17 +1633,64 @@ Vec2 Map::GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos) const
 	return resultDirection.GetNormalized();
 }
 
-Vec2 Map::GetSafeValueFromFlowField(IntVec2 tileCoords) const
+int Map::AcquireChaseField(std::vector<IntVec2> const& goalTiles)
+{
+	// Same goals in any order share a field
+	m_chaseGoalScratch = goalTiles;
+	std::sort(m_chaseGoalScratch.begin(), m_chaseGoalScratch.end(), [](IntVec2 const& a, IntVec2 const& b)
+		{
+			return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+		});
+	m_chaseGoalScratch.erase(std::unique(m_chaseGoalScratch.begin(), m_chaseGoalScratch.end()), m_chaseGoalScratch.end());
+
+	int fieldId = m_chaseFields.FindField(m_chaseGoalScratch);
+	if (fieldId < 0)
+	{
+		fieldId = m_chaseFields.AddField(m_chaseGoalScratch);
+		BuildChaseField(m_chaseGoalScratch, m_chaseFields.GetFlowFieldToBuild(fieldId));
+	}
+	m_chaseFields.AddReference(fieldId);
+	return fieldId;
+}
+
+void Map::ReleaseChaseField(int fieldId)
+{
+	m_chaseFields.RemoveReference(fieldId);
+}
+
+Vec2 Map::GetChaseDirectionFromWorldPos(int fieldId, Vec2 const& worldPos) const
+{
+	return GetBilinearInterpResultFromWorldPos(m_chaseFields.GetFlowField(fieldId), worldPos);
+}
+
+void Map::BuildChaseField(std::vector<IntVec2> const& goalTiles, TileDirectionGrid& out_flowField)
+{
+	// Walking distance to the nearest goal, then the same descent as the flee field
+	TileDistanceGrid& distanceMap = m_chaseDistanceScratch;
+	distanceMap.SetAllValues(SPECIAL_VALUE_POS);
+	for (int goalIndex = 0; goalIndex < (int)goalTiles.size(); ++goalIndex)
+	{
+		IntVec2 const& goalTile = goalTiles[goalIndex];
+		if (!IsTileUnreachable(goalTile.x, goalTile.y))
+		{
+			distanceMap.SetValueAtCoords(goalTile, 0.f);
+		}
+	}
+	SpreadDistanceMapHeatOnReachableMap(distanceMap, 0.f, 1.f);
+	m_chaseFlowFieldBuilder.Build(distanceMap, g_theWorkerPool, out_flowField);
+}
+
+Vec2 Map::GetSafeValueFromFlowField(TileDirectionGrid const& flowField, IntVec2 tileCoords) const
 {
 	// It can not become engine code, need to be written every time
 
-	if (m_flowField->IsInBounds(tileCoords))
+	if (flowField.IsInBounds(tileCoords))
 	{
-		return m_flowField->GetValueAtCoords(tileCoords);
+		return flowField.GetDirection(tileCoords);
 	}
 
 	// Out of Bounds: Has default value
-	IntVec2 dimensions = m_flowField->m_dimensions;
+	IntVec2 dimensions = flowField.GetDimensions();
 
 	if (tileCoords.x == -1 && tileCoords.y == -1)
 	{
@@ -706,12 +1754,9 @@ void Map::RenderStatics() const
 
 void Map::RenderActors() const
 {
-	for (Actor* actor : m_allActors)
+	for (Actor* actor : m_liveActors)
 	{
-		if (actor != nullptr)
-		{
-			actor->Render();
-		}
+		actor->Render();
 	}
 }
 
@@ -733,7 +1778,12 @@ void Map::DrawReachableMap() const
 
 	Vec2 dimensions = Vec2(static_cast<float>(m_dimensions.x), static_cast<float>(m_dimensions.y));
 
-	m_reachableMap->AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), FloatRange(0.f, UNREACHABLE_VALUE), Rgba8::TRANSPARENT_BLACK, Rgba8::MAGENTA);
+	TileHeatMap reachableMap(m_dimensions); // decoded from the reachability bits, debug only
+	for (int tileIndex = 0; tileIndex < reachableMap.GetNumTiles(); ++tileIndex)
+	{
+		reachableMap.SetValueAtIndex(tileIndex, m_unreachableTiles.IsSet(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x) ? UNREACHABLE_VALUE : 0.f);
+	}
+	reachableMap.AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), FloatRange(0.f, UNREACHABLE_VALUE), Rgba8::TRANSPARENT_BLACK, Rgba8::MAGENTA);
 
 	g_theRenderer->SetModelConstants(Mat44::MakeTranslation3D(Vec3(0.f, 0.f, 0.01f)));
 	g_theRenderer->BindTexture(nullptr);
@@ -752,7 +1802,9 @@ void Map::DrawExposureMap() const
 
 	Vec2 dimensions = Vec2(static_cast<float>(m_dimensions.x), static_cast<float>(m_dimensions.y));
 
-	m_exposureMap->AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), m_exposureMap->GetRangeOffValuesExcludingSpecial(SPECIAL_VALUE_POS), 0.5f,
+	TileHeatMap exposureMap(m_dimensions); // decoded, debug only
+	m_exposureMap->CopyToHeatMap(exposureMap);
+	exposureMap.AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), exposureMap.GetRangeOffValuesExcludingSpecial(SPECIAL_VALUE_POS), 0.5f,
 		Rgba8(0, 233, 233), Rgba8(0, 0, 255), Rgba8(70, 0, 0), Rgba8(255, 0, 0), SPECIAL_VALUE_POS, Rgba8::YELLOW);
 
 	g_theRenderer->SetModelConstants(Mat44::MakeTranslation3D(Vec3(0.f, 0.f, 0.02f)));
@@ -772,7 +1824,9 @@ void Map::DrawFlowField() const
 
 	Vec2 dimensions = Vec2(static_cast<float>(m_dimensions.x), static_cast<float>(m_dimensions.y));
 
-	m_flowField->AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), 0.1f, Rgba8::GREEN);
+	TileVectorField flowField(m_dimensions, Vec2::ZERO); // decoded, debug only
+	m_flowField->CopyToVectorField(flowField);
+	flowField.AddVertsForDebugDraw(verts, AABB2(Vec2::ZERO, dimensions), 0.1f, Rgba8::GREEN);
 
 	g_theRenderer->SetModelConstants(Mat44::MakeTranslation3D(Vec3(0.f, 0.f, 0.021f)));
 	g_theRenderer->BindTexture(nullptr);
@@ -799,17 +1853,88 @@ void Map::RenderScreenDebug() const
 
 	//Camera const& currentScreenCamera = g_theGame->m_currentRenderingPlayer->m_screenCamera;
 	//AABB2 cameraBounds = AABB2(currentScreenCamera.GetOrthographicBottomLeft(), currentScreenCamera.GetOrthographicTopRight());
+
+	AABB2 collisionBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.93f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.96f));
+	char const* broadphaseName = (m_actorBroadphaseMode == ActorBroadphaseMode::BRUTE_FORCE) ? "BruteForce" : "UniformGrid";
+	char const* narrowphaseName = "Scalar";
+	if (m_actorBroadphaseMode == ActorBroadphaseMode::UNIFORM_GRID && m_actorNarrowphaseMode == ActorNarrowphaseMode::BATCHED)
+	{
+		narrowphaseName = "Batched";
+	}
+	else if (m_actorBroadphaseMode == ActorBroadphaseMode::UNIFORM_GRID && m_actorNarrowphaseMode == ActorNarrowphaseMode::JACOBI)
+	{
+		narrowphaseName = "Jacobi";
+	}
+	DebugAddScreenText(Stringf("Broadphase: %s Narrowphase: %s Pairs: %d Collide: %.3fms", broadphaseName, narrowphaseName, m_numActorPairsTested, m_actorCollisionMilliseconds),
+		collisionBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 navBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.90f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.93f));
+	char const* visibilityName = (m_exposureVisibilityMode == ExposureVisibilityMode::RAYCAST) ? "Raycast" : "Shadowcast";
+	char const* navUpdateName = "Blocking";
+	if (m_navUpdateMode == NavUpdateMode::BACKGROUND_THREAD)
+	{
+		navUpdateName = "Thread";
+	}
+	else if (m_navUpdateMode == NavUpdateMode::TIME_SLICED)
+	{
+		navUpdateName = "TimeSliced";
+	}
+	std::string navText = Stringf("Visibility: %s Nav Cache: %d/%d Hit Rate: %.1f%% %s Age: %d frames", visibilityName, m_navFieldCache.GetNumEntries(), m_navFieldCache.GetCapacity(),
+		m_navFieldCache.GetHitRate() * 100.f, navUpdateName, GetNavAgeInFrames());
+	if (m_navSectors.IsBuilt())
+	{
+		navText = Stringf("Nav Sectors: %d Portals: %d Built: %d", m_navSectors.GetNumSectors(), m_navSectors.GetNumPortals(), (int)m_builtNavSectors.size());
+	}
+	DebugAddScreenText(navText, navBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 pvsBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.87f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.90f));
+	std::string pvsText = "PVS: Off";
+	if (m_tileVisibility.IsBuilt())
+	{
+		pvsText = Stringf("PVS: Radius %d Tiles: %d Memory: %.1fKB Build: %.1fms", m_tileVisibility.GetRadius(), m_tileVisibility.GetNumSourceTiles(),
+			static_cast<float>(m_tileVisibility.GetMemoryBytes()) / 1024.f, m_tileVisibilityBuildMilliseconds);
+	}
+	DebugAddScreenText(pvsText, pvsBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 chaseBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.84f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.87f));
+	DebugAddScreenText(Stringf("Chase Fields: %d References: %d Builds: %d", m_chaseFields.GetNumFields(), m_chaseFields.GetNumReferences(), m_chaseFields.GetNumBuilds()),
+		chaseBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 flowBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.81f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.84f));
+	int numNavGridBytes = 2 * (m_exposureMap->GetMemoryBytes() + m_flowField->GetMemoryBytes()) + m_navFieldCache.GetMemoryBytes();
+	std::string flowText = Stringf("Flow Field: Full Nav Grids: %.1fKB", static_cast<float>(numNavGridBytes) / 1024.f);
+	if (m_isFlowFieldLazy)
+	{
+		int numTouchedTiles = (m_lazyFlowCountVersion == m_flowFieldVersion) ? m_numLazyFlowTiles : 0;
+		flowText = Stringf("Flow Field: Lazy Touched: %d/%d tiles Nav Grids: %.1fKB", numTouchedTiles, m_dimensions.x * m_dimensions.y,
+			static_cast<float>(numNavGridBytes) / 1024.f);
+	}
+	DebugAddScreenText(flowText, flowBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 queryBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.78f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.81f));
+	char const* actorRaycastName = (m_actorRaycastMode == ActorRaycastMode::BRUTE_FORCE) ? "BruteForce" : "Traversal";
+	DebugAddScreenText(Stringf("Spatial Queries: %d Resolve: %.3fms Actor Raycast: %s", m_spatialQueries.GetNumResolvedQueries(), m_spatialQueries.GetResolveMilliseconds(), actorRaycastName),
+		queryBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
+
+	AABB2 poolBox = AABB2(Vec2(SCREEN_SIZE_X * 0.6f, SCREEN_SIZE_Y * 0.75f), Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y * 0.78f));
+	DebugAddScreenText(Stringf("Actor Pool: %d/%d Chunks: %d", m_actorPool.GetNumLiveActors(), m_actorPool.GetNumPooledActors(), m_actorPool.GetNumChunks()),
+		poolBox, 15.f, Vec2(0.98f, 0.5f), 0.f, 0.7f);
 }
 
-RaycastResultWithActor Map::RaycastAll(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner /*= nullptr*/) const
+RaycastResultWithActor Map::RaycastAll(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner /*= nullptr*/, RaycastResultWithActor const* worldXYResult /*= nullptr*/) const
 {
+	if (m_actorRaycastMode == ActorRaycastMode::TRAVERSAL)
+	{
+		return RaycastAllTraversal(start, direction, distance, owner, worldXYResult);
+	}
+
 	RaycastResultWithActor raycastAllResult;
 	raycastAllResult.m_rayStartPos = start;
 	raycastAllResult.m_rayFwdNormal = direction;
 	raycastAllResult.m_rayLength = distance;
 
 
-	RaycastResultWithActor result = RaycastWorldXY(start, direction, distance);
+	RaycastResultWithActor result = (worldXYResult != nullptr) ? *worldXYResult : RaycastWorldXY(start, direction, distance);
 	if (result.m_didImpact)
 	{
 		if (!raycastAllResult.m_didImpact)
@@ -939,6 +2064,80 @@ RaycastResultWithActor Map::RaycastWorldXY(Vec3 const& start, Vec3 const& direct
 	/*return raycastResult;*/
 }
 
+void Map::RaycastWorldXYBatch(Vec3 const& start, std::vector<Vec3> const& directions, float distance, VoxelRayBatch& rayBatch, std::vector<RaycastResultWithActor>& out_results) const
+{
+	// The map bounds check of RaycastWorldXY becomes one clip per ray
+	rayBatch.Clear();
+	int numRays = (int)directions.size();
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		float minHitDist = 0.f;
+		float maxHitDist = 0.f;
+		ClipRayToMapBounds(start, directions[rayIndex], minHitDist, maxHitDist);
+		rayBatch.AddClippedRay(Vec2(start.x, start.y), Vec2(directions[rayIndex].x, directions[rayIndex].y), distance, minHitDist, maxHitDist);
+	}
+
+	rayBatch.Trace(m_solidTiles);
+	out_results.assign(numRays, RaycastResultWithActor());
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		VoxelRayHit const& hit = rayBatch.GetHit(rayIndex);
+		Vec3 const& direction = directions[rayIndex];
+		RaycastResultWithActor& raycastResult = out_results[rayIndex];
+		raycastResult.m_rayStartPos = start;
+		raycastResult.m_rayFwdNormal = direction;
+		raycastResult.m_rayLength = distance;
+		raycastResult.m_didImpact = hit.m_didImpact;
+		raycastResult.m_impactDist = hit.m_impactDist;
+		if (hit.m_isStartInside)
+		{
+			raycastResult.m_impactPos = start;
+			raycastResult.m_impactNormal = -direction;
+		}
+		else if (hit.m_didImpact)
+		{
+			raycastResult.m_impactPos = start + raycastResult.m_impactDist * direction;
+			raycastResult.m_impactNormal = Vec3(hit.m_impactNormal.x, hit.m_impactNormal.y, 0.f);
+		}
+	}
+}
+
+void Map::ClipRayToMapBounds(Vec3 const& start, Vec3 const& direction, float& out_minDist, float& out_maxDist) const
+{
+	// Slab test against the IsPositionInBounds box; it is convex, so the ray is inside for one interval at most
+	Vec3 small = Vec3(0.0001f, 0.0001f, 0.0001f);
+	Vec3 mins = Vec3::ZERO - small;
+	Vec3 maxs = Vec3((float)m_dimensions.x, (float)m_dimensions.y, 1.f) + small;
+	float const starts[3] = { start.x, start.y, start.z };
+	float const directions[3] = { direction.x, direction.y, direction.z };
+	float const minBounds[3] = { mins.x, mins.y, mins.z };
+	float const maxBounds[3] = { maxs.x, maxs.y, maxs.z };
+
+	out_minDist = -FLT_MAX;
+	out_maxDist = FLT_MAX;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (directions[axis] == 0.f)
+		{
+			if (starts[axis] < minBounds[axis] || starts[axis] > maxBounds[axis])
+			{
+				out_minDist = FLT_MAX;
+				out_maxDist = -FLT_MAX;
+				return;
+			}
+			continue;
+		}
+		float entryDist = (minBounds[axis] - starts[axis]) / directions[axis];
+		float exitDist = (maxBounds[axis] - starts[axis]) / directions[axis];
+		if (entryDist > exitDist)
+		{
+			std::swap(entryDist, exitDist);
+		}
+		out_minDist = (entryDist > out_minDist) ? entryDist : out_minDist;
+		out_maxDist = (exitDist < out_maxDist) ? exitDist : out_maxDist;
+	}
+}
+
 RaycastResultWithActor Map::RaycastWorldZ(Vec3 const& start, Vec3 const& direction, float distance) const
 {
 	float constexpr CEILINGZ = 1.f;
@@ -1004,29 +2203,13 @@ RaycastResultWithActor Map::RaycastWorldActors(Vec3 const& start, Vec3 const& di
 	int numActor = (int)m_allActors.size();
 	for (int actorIndex = 0; actorIndex < numActor; ++actorIndex)
 	{
-		Actor* actor = m_allActors[actorIndex];
-		// Self and Dead
-		if (owner == actor || !IsAlive(actor))
-		{
-			continue;
-		}
-		// Your projectile
-		if (actor->m_owner == owner->m_handle)
-		{
-			continue;
-		}
-		// Ignore those without collision
-		if (!actor->m_definition->m_collision.m_collidesWithActors && !actor->m_definition->m_collision.m_collidesWithWorld)
+		if (!IsActorRaycastTarget(actorIndex, owner))
 		{
 			continue;
 		}
+		Actor* actor = m_allActors[actorIndex];
 
-		Vec2 cylinderCenterXY = Vec2(actor->m_position.x, actor->m_position.y);
-		float cylinderRadius = actor->m_definition->m_collision.m_physicsRadius;
-		FloatRange cylinderMinMaxZ = FloatRange(actor->m_position.z , actor->m_position.z + actor->m_definition->m_collision.m_physicsHeight);
-
-
-		RaycastResult3D result = RaycastVsCylinderZ3D(start, direction, distance, cylinderCenterXY, cylinderMinMaxZ, cylinderRadius);
+		RaycastResult3D result = RaycastVsActorSlot(start, direction, distance, actorIndex);
 		if (result.m_didImpact)
 		{
 			if (!raycastResult.m_didImpact)
@@ -1053,40 +2236,267 @@ RaycastResultWithActor Map::RaycastWorldActors(Vec3 const& start, Vec3 const& di
 	return raycastResult;
 }
 
+RaycastResultWithActor Map::RaycastAllTraversal(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner, RaycastResultWithActor const* worldXYResult) const
+{
+	// Same hits as the brute-force RaycastAll, ties still go to walls, then floor/ceiling, then the lowest actor index
+	UpdateActorRaycastGrid();
+
+	RaycastResultWithActor zResult = RaycastWorldZ(start, direction, distance);
+	RaycastResultWithActor wallResult;
+	wallResult.m_rayStartPos = start;
+	wallResult.m_rayFwdNormal = direction;
+	wallResult.m_rayLength = distance;
+	bool isWallTested = (worldXYResult == nullptr);
+	if (!isWallTested)
+	{
+		wallResult = *worldXYResult;
+	}
+
+	// The walk never needs to go past the floor, the ceiling or an already known wall
+	float walkLength = distance;
+	if (zResult.m_didImpact)
+	{
+		walkLength = zResult.m_impactDist;
+	}
+	if (wallResult.m_didImpact && wallResult.m_impactDist < walkLength)
+	{
+		walkLength = wallResult.m_impactDist;
+	}
+
+	int tileX = RoundDownToInt(start.x);
+	int tileY = RoundDownToInt(start.y);
+	bool isWalking = true;
+	if (isWallTested && IsTileSolid(tileX, tileY) && IsPositionInBounds(start))
+	{
+		wallResult.m_didImpact = true;
+		wallResult.m_impactPos = start;
+		wallResult.m_impactNormal = -direction;
+		isWalking = false;
+	}
+
+	// Same crossings as RaycastWorldXY, a zero direction component never crosses
+	float fwdDistPerXCrossing = FLT_MAX;
+	float fwdDistAtNextXCrossing = FLT_MAX;
+	int tileStepDirectionX = (direction.x < 0.f) ? -1 : 1;
+	if (direction.x != 0.f)
+	{
+		fwdDistPerXCrossing = 1.0f / fabsf(direction.x);
+		float xAtFirstXCrossing = static_cast<float>(tileX) + static_cast<float>(tileStepDirectionX + 1) * 0.5f;
+		fwdDistAtNextXCrossing = fabsf(xAtFirstXCrossing - start.x) * fwdDistPerXCrossing;
+	}
+	float fwdDistPerYCrossing = FLT_MAX;
+	float fwdDistAtNextYCrossing = FLT_MAX;
+	int tileStepDirectionY = (direction.y < 0.f) ? -1 : 1;
+	if (direction.y != 0.f)
+	{
+		fwdDistPerYCrossing = 1.0f / fabsf(direction.y);
+		float yAtFirstYCrossing = static_cast<float>(tileY) + static_cast<float>(tileStepDirectionY + 1) * 0.5f;
+		fwdDistAtNextYCrossing = fabsf(yAtFirstYCrossing - start.y) * fwdDistPerYCrossing;
+	}
+
+	RaycastResult3D actorResult;
+	int hitActorIndex = -1;
+	int lastCellIndex = -1;
+	while (isWalking)
+	{
+		// Outside of the map the clamped border cell repeats, its actors are only tested once
+		int cellIndex = m_actorRaycastGrid.GetCellIndexClamped(tileX, tileY);
+		if (cellIndex != lastCellIndex)
+		{
+			lastCellIndex = cellIndex;
+			m_actorRaycastGrid.ForEachActorInCell(cellIndex, [&](int actorIndex)
+				{
+					if (!IsActorRaycastTarget(actorIndex, owner))
+					{
+						return;
+					}
+					RaycastResult3D result = RaycastVsActorSlot(start, direction, distance, actorIndex);
+					if (!result.m_didImpact)
+					{
+						return;
+					}
+					if (hitActorIndex < 0 || result.m_impactDist < actorResult.m_impactDist ||
+						(result.m_impactDist == actorResult.m_impactDist && actorIndex < hitActorIndex))
+					{
+						actorResult = result;
+						hitActorIndex = actorIndex;
+					}
+				});
+		}
+
+		// Actors in later tiles are hit at the next crossing or further, so a nearer hit is final
+		bool isXCrossing = (fwdDistAtNextXCrossing <= fwdDistAtNextYCrossing);
+		float fwdDistAtNextCrossing = isXCrossing ? fwdDistAtNextXCrossing : fwdDistAtNextYCrossing;
+		if (hitActorIndex >= 0 && actorResult.m_impactDist < fwdDistAtNextCrossing)
+		{
+			break;
+		}
+		if (fwdDistAtNextCrossing > walkLength)
+		{
+			break;
+		}
+
+		if (isXCrossing)
+		{
+			tileX += tileStepDirectionX;
+		}
+		else
+		{
+			tileY += tileStepDirectionY;
+		}
+		if (isWallTested && IsPositionInBounds(start + fwdDistAtNextCrossing * direction) && IsTileSolid(tileX, tileY))
+		{
+			wallResult.m_didImpact = true;
+			wallResult.m_impactDist = fwdDistAtNextCrossing;
+			wallResult.m_impactPos = start + wallResult.m_impactDist * direction;
+			wallResult.m_impactNormal = isXCrossing ? Vec3(-static_cast<float>(tileStepDirectionX), 0.f, 0.f) : Vec3(0.f, -static_cast<float>(tileStepDirectionY), 0.f);
+			break;
+		}
+		if (isXCrossing)
+		{
+			fwdDistAtNextXCrossing += fwdDistPerXCrossing;
+		}
+		else
+		{
+			fwdDistAtNextYCrossing += fwdDistPerYCrossing;
+		}
+	}
+
+	RaycastResultWithActor raycastAllResult;
+	raycastAllResult.m_rayStartPos = start;
+	raycastAllResult.m_rayFwdNormal = direction;
+	raycastAllResult.m_rayLength = distance;
+	if (wallResult.m_didImpact)
+	{
+		raycastAllResult = wallResult;
+	}
+	if (zResult.m_didImpact && (!raycastAllResult.m_didImpact || raycastAllResult.m_impactDist > zResult.m_impactDist))
+	{
+		raycastAllResult = zResult;
+	}
+	if (hitActorIndex >= 0 && (!raycastAllResult.m_didImpact || raycastAllResult.m_impactDist > actorResult.m_impactDist))
+	{
+		raycastAllResult.m_didImpact = true;
+		raycastAllResult.m_impactDist = actorResult.m_impactDist;
+		raycastAllResult.m_impactPos = actorResult.m_impactPos;
+		raycastAllResult.m_impactNormal = actorResult.m_impactNormal;
+		raycastAllResult.m_hitActor = m_allActors[hitActorIndex];
+	}
+	return raycastAllResult;
+}
+
+RaycastResult3D Map::RaycastVsActorSlot(Vec3 const& start, Vec3 const& direction, float distance, int actorIndex) const
+{
+	Vec2 cylinderCenterXY = Vec2(m_actorPhysics.m_positionX[actorIndex], m_actorPhysics.m_positionY[actorIndex]);
+	float cylinderRadius = m_actorPhysics.m_radius[actorIndex];
+	FloatRange cylinderMinMaxZ = FloatRange(m_actorPhysics.m_positionZ[actorIndex], m_actorPhysics.m_positionZ[actorIndex] + m_actorPhysics.m_height[actorIndex]);
+	return RaycastVsCylinderZ3D(start, direction, distance, cylinderCenterXY, cylinderMinMaxZ, cylinderRadius);
+}
+
+bool Map::IsActorRaycastTarget(int actorIndex, Actor const* owner) const
+{
+	Actor const* actor = m_allActors[actorIndex];
+	// Self and Dead
+	if (owner == actor || !IsAlive(actor))
+	{
+		return false;
+	}
+	// Your projectile
+	if (owner != nullptr && actor->m_owner == owner->m_handle)
+	{
+		return false;
+	}
+	// Ignore those without collision
+	if (!m_actorPhysics.HasFlags(actorIndex, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS) && !m_actorPhysics.HasFlags(actorIndex, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_WORLD))
+	{
+		return false;
+	}
+	return true;
+}
+
+void Map::UpdateActorRaycastGrid() const
+{
+	if (!m_isActorRaycastGridDirty)
+	{
+		return;
+	}
+	m_isActorRaycastGridDirty = false;
+
+	// Actors that die later in the frame stay bucketed, IsActorRaycastTarget skips them
+	m_actorRaycastGrid.BeginRebuild();
+	for (int slot = 0; slot < m_actorPhysics.GetNumSlots(); ++slot)
+	{
+		if (!m_actorPhysics.HasFlags(slot, ACTOR_PHYSICS_FLAG_ALIVE))
+		{
+			continue;
+		}
+		if (!m_actorPhysics.HasFlags(slot, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_ACTORS) && !m_actorPhysics.HasFlags(slot, ACTOR_PHYSICS_FLAG_COLLIDES_WITH_WORLD))
+		{
+			continue;
+		}
+		m_actorRaycastGrid.AddActor(slot, m_actorPhysics.m_positionX[slot], m_actorPhysics.m_positionY[slot], m_actorPhysics.m_radius[slot]);
+	}
+	m_actorRaycastGrid.EndRebuild();
+}
+
 void Map::DeleteDestroyedActors()
 {
-	for (int actorIndex = 0; actorIndex < (int)m_allActors.size(); ++actorIndex)
+	for (int liveIndex = 0; liveIndex < (int)m_liveActors.size();)
 	{
-		Actor* actor = m_allActors[actorIndex];
-		if (actor != nullptr && actor->m_isGarbage)
+		Actor* actor = m_liveActors[liveIndex];
+		if (!actor->m_isGarbage)
+		{
+			++liveIndex;
+			continue;
+		}
+
+		int actorIndex = (int)actor->m_handle.GetIndex();
+		m_actorPool.DestroyActor(actor);
+		m_allActors[actorIndex] = nullptr;
+		m_actorPhysics.RemoveActor(actorIndex);
+		m_actorSlotGenerations[actorIndex]++;
+		m_freeActorSlots.push_back(actorIndex);
+
+		// Move the last live actor into the hole
+		Actor* lastActor = m_liveActors.back();
+		m_liveActors.pop_back();
+		if (lastActor != actor)
 		{
-			delete actor;
-			m_allActors[actorIndex] = nullptr;
+			m_liveActors[liveIndex] = lastActor;
 		}
 	}
 }
 
 Actor* Map::SpawnActor(SpawnInfo const& spawnInfo)
 {
-	if (m_currentUid >= ActorHandle::MAX_ACTOR_UID || m_allActors.size() >= ActorHandle::MAX_ACTOR_INDEX)
+	return SpawnActor(spawnInfo, ActorDefinition::GetByName(spawnInfo.m_actor));
+}
+
+Actor* Map::SpawnActor(SpawnInfo const& spawnInfo, ActorDefinition const* definition)
+{
+	// Most recently freed slot first, a new slot only when none is free
+	int actorIndex = -1;
+	if (!m_freeActorSlots.empty())
 	{
-		ERROR_AND_DIE("Num of Actors reaches maximum.");
+		actorIndex = m_freeActorSlots.back();
+		m_freeActorSlots.pop_back();
 	}
-	// find empty slot
-	for (int actorIndex = 0; actorIndex < (int)m_allActors.size(); ++actorIndex)
+	else
 	{
-		if (m_allActors[actorIndex] == nullptr)
+		if (m_allActors.size() >= ActorHandle::MAX_ACTOR_INDEX)
 		{
-			Actor* newActor = new Actor(this, spawnInfo, ActorHandle(m_currentUid, actorIndex));
-			m_allActors[actorIndex] = newActor;
-			m_currentUid++;
-			return newActor;
+			ERROR_AND_DIE("Num of Actors reaches maximum.");
 		}
+		actorIndex = (int)m_allActors.size();
+		m_allActors.push_back(nullptr);
+		m_actorSlotGenerations.push_back(0);
 	}
-	// no empty slot
-	Actor* newActor = new Actor(this, spawnInfo, ActorHandle(m_currentUid, static_cast<unsigned int>(m_allActors.size())));
-	m_allActors.push_back(newActor);
-	m_currentUid++;
+
+	m_actorPhysics.AddActor(actorIndex, definition, spawnInfo.m_position, spawnInfo.m_velocity);
+	m_isActorRaycastGridDirty = true;
+	Actor* newActor = m_actorPool.CreateActor(this, spawnInfo, definition, ActorHandle(m_actorSlotGenerations[actorIndex], static_cast<unsigned int>(actorIndex)));
+	m_allActors[actorIndex] = newActor;
+	m_liveActors.push_back(newActor);
 	return newActor;
 }
 
@@ -1097,17 +2507,70 @@ void Map::SpawnPlayer(int playerIndex)
 	{
 		ERROR_AND_DIE("No spawn points in the map.");
 	}
-	int randomIndex = g_rng.RollRandomIntLessThan(numSpawnPoint);
+	SpawnInfo const& spawnPoint = m_spawnPoints[ChoosePlayerSpawnPoint()];
 	SpawnInfo info;
 	info.m_actor = "Marine";
-	info.m_position = m_spawnPoints[randomIndex].m_position;
-	info.m_orientation = m_spawnPoints[randomIndex].m_orientation;
-	info.m_velocity = m_spawnPoints[randomIndex].m_velocity;
+	info.m_position = spawnPoint.m_position;
+	info.m_orientation = spawnPoint.m_orientation;
+	info.m_velocity = spawnPoint.m_velocity;
 	Actor* newMarine = SpawnActor(info);
 
 	g_theGame->m_players[playerIndex]->Possess(newMarine);
 }
 
+int Map::ChoosePlayerSpawnPoint() const
+{
+	// A random spawn point in a region with a living demon, so a player never starts in an arena with nothing left to hunt.
+	// Without any demon left, a spawn point in the largest region.
+	std::vector<int> numDemonsInRegions(m_tileRegions.GetNumRegions(), 0);
+	for (Actor const* actor : m_liveActors)
+	{
+		if (!IsAlive(actor) || actor->m_definition->m_faction != Faction::DEMON)
+		{
+			continue;
+		}
+		IntVec2 tileCoords = GetCoordsForWorldPos(actor->m_position.x, actor->m_position.y);
+		int regionId = GetTileRegion(tileCoords.x, tileCoords.y);
+		if (regionId != NO_REGION)
+		{
+			numDemonsInRegions[regionId]++;
+		}
+	}
+
+	std::vector<int> candidateSpawnPoints;
+	int largestRegionSize = 0;
+	for (int spawnIndex = 0; spawnIndex < (int)m_spawnPoints.size(); ++spawnIndex)
+	{
+		IntVec2 tileCoords = GetCoordsForWorldPos(m_spawnPoints[spawnIndex].m_position.x, m_spawnPoints[spawnIndex].m_position.y);
+		int regionId = GetTileRegion(tileCoords.x, tileCoords.y);
+		if (regionId != NO_REGION && numDemonsInRegions[regionId] > 0)
+		{
+			candidateSpawnPoints.push_back(spawnIndex);
+		}
+		if (regionId != NO_REGION && m_tileRegions.GetRegionSize(regionId) > largestRegionSize)
+		{
+			largestRegionSize = m_tileRegions.GetRegionSize(regionId);
+		}
+	}
+	if (candidateSpawnPoints.empty())
+	{
+		for (int spawnIndex = 0; spawnIndex < (int)m_spawnPoints.size(); ++spawnIndex)
+		{
+			IntVec2 tileCoords = GetCoordsForWorldPos(m_spawnPoints[spawnIndex].m_position.x, m_spawnPoints[spawnIndex].m_position.y);
+			int regionId = GetTileRegion(tileCoords.x, tileCoords.y);
+			if (regionId != NO_REGION && m_tileRegions.GetRegionSize(regionId) == largestRegionSize)
+			{
+				candidateSpawnPoints.push_back(spawnIndex);
+			}
+		}
+	}
+	if (candidateSpawnPoints.empty())
+	{
+		return g_rng.RollRandomIntLessThan((int)m_spawnPoints.size()); // every spawn point is inside a wall
+	}
+	return candidateSpawnPoints[g_rng.RollRandomIntLessThan((int)candidateSpawnPoints.size())];
+}
+
 Actor* Map::GetActorByHandle(ActorHandle const& handle) const
 {
 	if (!handle.IsValid())
@@ -1115,6 +2578,11 @@ Actor* Map::GetActorByHandle(ActorHandle const& handle) const
 		return nullptr;
 	}
 
+	if (handle.GetIndex() >= m_allActors.size())
+	{
+		return nullptr;
+	}
+
 	Actor* actor = m_allActors[handle.GetIndex()];
 	if (actor != nullptr && actor->m_handle == handle)
 	{
@@ -1126,47 +2594,6 @@ Actor* Map::GetActorByHandle(ActorHandle const& handle) const
 	}
 }
 
-Actor* Map::GetClosestVisibleEnemy(Actor* self)
-{
-	Actor* closestActor = nullptr;
-	float closestDistanceSquared = 100000000.f;
-
-	int numActor = (int)m_allActors.size();
-	for (int actorIndex = 0; actorIndex < numActor; ++actorIndex)
-	{
-		Actor* actor = m_allActors[actorIndex];
-		if (!IsAlive(actor))
-		{
-			continue;
-		}
-		if (!self->IsOpposingFaction(actor->m_definition->m_faction))
-		{
-			continue;
-		}
-		if (IsPointInsideDirectedSector2D(Vec2(actor->m_position.x, actor->m_position.y), Vec2(self->m_position.x, self->m_position.y), self->GetForwardNormal2D(), self->m_definition->m_ai.m_sightAngle, self->m_definition->m_ai.m_sightRadius))
-		{
-			Vec3 disp = (actor->m_position - self->m_position);
-			Vec3 startPos = self->GetEyePosition();
-			Vec3 direction = disp.GetNormalized();
-			float distance = self->m_definition->m_ai.m_sightRadius;
-
-			RaycastResultWithActor result = RaycastWorldXY(startPos, direction, distance);
-			float distanceXYSquared = Vec2(disp.x, disp.y).GetLengthSquared();
-			if (!result.m_didImpact || result.m_impactDist * result.m_impactDist > distanceXYSquared)
-			{
-				if (distanceXYSquared < closestDistanceSquared)
-				{
-					closestActor = actor;
-					closestDistanceSquared = distanceXYSquared;
-				}
-			}
-		}
-		
-	}
-
-	return closestActor;
-}
-
 void Map::DebugPossessNext(Player* playerController)
 {
 	if (playerController == nullptr)
@@ -1207,9 +2634,9 @@ bool Map::IsAlive(Actor const* actor) const
 
 bool Map::IsGameFinished() const
 {
-	for (Actor* actor : m_allActors)
+	for (Actor* actor : m_liveActors)
 	{
-		if (actor != nullptr && actor->m_definition->m_faction == Faction::DEMON)
+		if (actor->m_definition->m_faction == Faction::DEMON)
 		{
 			return false;
 		}
@@ -1220,9 +2647,9 @@ bool Map::IsGameFinished() const
 void Map::ShowNumOfAliveDemons() const
 {
 	int numOfDemons = 0;
-	for (Actor* actor : m_allActors)
+	for (Actor* actor : m_liveActors)
 	{
-		if (actor != nullptr && actor->m_definition->m_faction == Faction::DEMON && !actor->m_isDead)
+		if (actor->m_definition->m_faction == Faction::DEMON && !actor->m_isDead)
 		{
 			numOfDemons++;
 		}
@@ -1251,28 +2678,183 @@ void Map::CreateTiles()
 			m_tiles[tileIndex].m_tileDef = tileDef;
 		}
 	}
+
+	m_solidTiles.Initialize(m_dimensions, true);
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			m_solidTiles.Set(tileX, tileY, m_tiles[tileX + tileY * m_dimensions.x].m_tileDef->m_isSolid);
+		}
+	}
+
+	m_actorGrid.Initialize(m_dimensions);
+	m_actorRaycastGrid.Initialize(m_dimensions);
+}
+
+void Map::CreateWallDistanceField()
+{
+	// Ring search around each tile center, out of bounds counts as solid
+	m_wallDistances.resize(m_dimensions.x * m_dimensions.y);
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			int tileIndex = tileX + tileY * m_dimensions.x;
+			if (m_solidTiles.IsSet(tileX, tileY))
+			{
+				m_wallDistances[tileIndex] = 0.f;
+				continue;
+			}
+
+			float maxDistance = static_cast<float>(WALL_DISTANCE_SEARCH_RADIUS) + 0.5f;
+			float bestDistanceSquared = maxDistance * maxDistance;
+			for (int ring = 1; ring <= WALL_DISTANCE_SEARCH_RADIUS; ++ring)
+			{
+				float ringMinDistance = static_cast<float>(ring) - 0.5f;
+				if (ringMinDistance * ringMinDistance >= bestDistanceSquared)
+				{
+					break;
+				}
+				for (int offsetY = -ring; offsetY <= ring; ++offsetY)
+				{
+					int stepX = (offsetY == -ring || offsetY == ring) ? 1 : 2 * ring;
+					for (int offsetX = -ring; offsetX <= ring; offsetX += stepX)
+					{
+						if (!m_solidTiles.IsSetSafe(tileX + offsetX, tileY + offsetY, true))
+						{
+							continue;
+						}
+						float gapX = static_cast<float>(abs(offsetX)) - 0.5f;
+						float gapY = static_cast<float>(abs(offsetY)) - 0.5f;
+						gapX = (gapX > 0.f) ? gapX : 0.f;
+						gapY = (gapY > 0.f) ? gapY : 0.f;
+						float distanceSquared = gapX * gapX + gapY * gapY;
+						if (distanceSquared < bestDistanceSquared)
+						{
+							bestDistanceSquared = distanceSquared;
+						}
+					}
+				}
+			}
+			m_wallDistances[tileIndex] = sqrtf(bestDistanceSquared);
+		}
+	}
 }
 
 void Map::CreateNavGrids()
 {
-	TileHeatMap floodMap = TileHeatMap(m_dimensions, SPECIAL_VALUE_POS);
-	Vec3 firstSpawnPoint = m_spawnPoints[0].m_position; // Need to be after having spawn points
-	floodMap.SetValueAtCoords(GetCoordsForWorldPos(firstSpawnPoint.x, firstSpawnPoint.y), 0.f);
-	SpreadDistanceMapHeat(floodMap, 0.f);
+	// Every region with a spawn point is reachable, so disconnected arenas each get their own flow
+	m_tileRegions.Build(m_solidTiles);
+	m_isRegionReachable.assign(m_tileRegions.GetNumRegions(), 0);
+	for (SpawnInfo const& spawnPoint : m_spawnPoints) // Need to be after having spawn points
+	{
+		int regionId = m_tileRegions.GetRegion(GetCoordsForWorldPos(spawnPoint.m_position.x, spawnPoint.m_position.y));
+		if (regionId != NO_REGION)
+		{
+			m_isRegionReachable[regionId] = 1;
+		}
+	}
 
-	m_reachableMap = new TileHeatMap(m_dimensions);
+	m_unreachableTiles.Initialize(m_dimensions, true);
 	// Fill Unreachable Tiles
-	int numTiles = m_reachableMap->GetNumTiles();
+	int numTiles = m_dimensions.x * m_dimensions.y;
 	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
 	{
-		if (floodMap.GetValueAtIndex(tileIndex) == SPECIAL_VALUE_POS)
+		int regionId = m_tileRegions.GetRegion(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x);
+		if (regionId == NO_REGION || !m_isRegionReachable[regionId])
+		{
+			m_unreachableTiles.Set(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x, true);
+		}
+	}
+
+	m_exposureMap = new TileDistanceGrid(m_dimensions);
+	m_flowField = new TileDirectionGrid(m_dimensions);
+	m_backExposureMap = new TileDistanceGrid(m_dimensions);
+	m_backFlowField = new TileDirectionGrid(m_dimensions);
+	m_flowFieldBuilder.Initialize(m_unreachableTiles);
+	m_chaseFlowFieldBuilder.Initialize(m_unreachableTiles);
+	m_chaseFields.Initialize(m_dimensions);
+	m_chaseDistanceScratch = TileDistanceGrid(m_dimensions);
+
+	m_navSectors.Build(m_unreachableTiles, m_definition->m_navSectorSize);
+	if (m_navSectors.IsBuilt())
+	{
+		m_exposedTiles.Initialize(m_dimensions, false);
+		m_isNavSectorBuilt.assign(m_navSectors.GetNumSectors(), 0);
+		int numSectorScratchTiles = (m_navSectors.GetSectorSize() + 2) * (m_navSectors.GetSectorSize() + 2); // largest sector plus its ring
+		m_navSectorValues.resize(numSectorScratchTiles);
+		m_navSectorDistances.resize(numSectorScratchTiles);
+		m_navSectorCurrentLevelTiles.reserve(numSectorScratchTiles);
+		m_navSectorNextLevelTiles.reserve(numSectorScratchTiles);
+		for (int sectorIndex = 0; sectorIndex < m_navSectors.GetNumSectors(); ++sectorIndex)
 		{
-			m_reachableMap->SetValueAtIndex(tileIndex, UNREACHABLE_VALUE);
+			ResetNavSector(sectorIndex);
 		}
 	}
+	m_navFieldCache.Initialize(m_dimensions, g_gameConfigBlackboard.GetValue("navFieldCacheSize", 16));
+
+	if (m_navSectors.IsBuilt())
+	{
+		m_isFlowFieldLazy = false; // sector nav already builds only the sectors AI are in
+	}
+	if (m_isFlowFieldLazy)
+	{
+		// The sampler border never changes, its tiles are kept current by EvaluateFlowTilesAround
+		m_flowTileVersions.assign(m_dimensions.x * m_dimensions.y, -1);
+		m_flowFieldSampler.Load(*m_flowField);
+		m_flowFieldSamplerVersion = m_flowFieldVersion;
+	}
+}
+
+void Map::CreateTileVisibilitySet()
+{
+	// Bake tile center to tile center line of sight with the same raycast CanTileSeeTile falls back to
+	double startTime = GetCurrentTimeSeconds();
+	m_tileVisibility.Initialize(m_dimensions, m_definition->m_pvsRadius, m_solidTiles);
+	if (!m_tileVisibility.IsBuilt())
+	{
+		m_tileVisibilityBuildMilliseconds = 0.0;
+		return;
+	}
 
-	m_exposureMap = new TileHeatMap(m_dimensions);
-	m_flowField = new TileVectorField(m_dimensions, Vec2::ZERO);
+	int radius = m_tileVisibility.GetRadius();
+	int numTiles = m_dimensions.x * m_dimensions.y;
+	RunParallelFor(g_theWorkerPool, numTiles, m_dimensions.x, [&](int beginTileIndex, int endTileIndex)
+		{
+			// Every ray of a source tile is traced in one batch
+			VoxelRayBatch rayBatch;
+			std::vector<IntVec2> toTiles;
+			for (int tileIndex = beginTileIndex; tileIndex < endTileIndex; ++tileIndex)
+			{
+				IntVec2 fromTile = IntVec2(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x);
+				if (m_solidTiles.IsSet(fromTile.x, fromTile.y))
+				{
+					continue;
+				}
+				rayBatch.Clear();
+				toTiles.clear();
+				Vec2 rayStart = GetTileCenter(fromTile.x, fromTile.y);
+				for (int toTileY = fromTile.y - radius; toTileY <= fromTile.y + radius; ++toTileY)
+				{
+					for (int toTileX = fromTile.x - radius; toTileX <= fromTile.x + radius; ++toTileX)
+					{
+						if (AreCoordsInBounds(toTileX, toTileY) && !m_solidTiles.IsSet(toTileX, toTileY))
+						{
+							Vec2 disp = GetTileCenter(toTileX, toTileY) - rayStart;
+							rayBatch.AddRay(rayStart, disp.GetNormalized(), disp.GetLength());
+							toTiles.push_back(IntVec2(toTileX, toTileY));
+						}
+					}
+				}
+				rayBatch.Trace(m_solidTiles);
+				for (int rayIndex = 0; rayIndex < rayBatch.GetNumRays(); ++rayIndex)
+				{
+					m_tileVisibility.SetVisible(fromTile, toTiles[rayIndex], !rayBatch.GetHit(rayIndex).m_didImpact);
+				}
+			}
+		});
+	m_tileVisibilityBuildMilliseconds = (GetCurrentTimeSeconds() - startTime) * 1000.0;
 }
 
 void Map::CreateGeometry()
@@ -1393,6 +2975,19 @@ void Map::CreateSpawnPoints()
 			m_spawnPoints.push_back(info);
 		}
 	}
+
+	// Spawn validation: players spawn as marines, warn about points where a marine would start inside a wall
+	ActorDefinition const* marineDefinition = ActorDefinition::GetByName("Marine");
+	GUARANTEE_OR_DIE(marineDefinition != nullptr, "No Marine in ActorDefs, players can not spawn");
+	float marineRadius = marineDefinition->m_collision.m_physicsRadius;
+	for (int spawnIndex = 0; spawnIndex < (int)m_spawnPoints.size(); ++spawnIndex)
+	{
+		Vec2 spawnPosition = Vec2(m_spawnPoints[spawnIndex].m_position.x, m_spawnPoints[spawnIndex].m_position.y);
+		if (!IsPositionClearOfWalls(spawnPosition, marineRadius))
+		{
+			DebugAddMessage(Stringf("Spawn point %d at (%.2f, %.2f) is within %.2f of a wall", spawnIndex, spawnPosition.x, spawnPosition.y, marineRadius), 10.f, Rgba8::YELLOW);
+		}
+	}
 }
 
 void Map::SpawnNonPlayerActors()
@@ -1415,7 +3010,7 @@ bool Map::IsPositionInBounds(Vec3 const& position) const
 
 bool Map::AreCoordsInBounds(int x, int y) const
 {
-	return (x >= 0) && (y >= 0) && (x <= m_dimensions.x) && (y <= m_dimensions.y);
+	return (x >= 0) && (y >= 0) && (x < m_dimensions.x) && (y < m_dimensions.y);
 }
 
 Tile const* Map::GetTile(int x, int y) const
@@ -1434,12 +3029,7 @@ IntVec2 Map::GetCoordsForWorldPos(float x, float y) const
 
 bool Map::IsTileSolid(int x, int y) const
 {
-	if (!AreCoordsInBounds(x, y))
-	{
-		return true;
-	}
-	Tile const* tile = GetTile(x, y);
-	return tile->m_tileDef->m_isSolid;
+	return m_solidTiles.IsSetSafe(x, y, true);
 }
 
 Vec2 Map::GetTileCenter(int tileX, int tileY) const
@@ -1447,3 +3037,20 @@ Vec2 Map::GetTileCenter(int tileX, int tileY) const
 	return Vec2(static_cast<float>(tileX) + 0.5f, static_cast<float>(tileY) + 0.5f);
 }
 
+float Map::GetWallClearance(Vec2 const& position) const
+{
+	IntVec2 tileCoords = GetCoordsForWorldPos(position.x, position.y);
+	if (!AreCoordsInBounds(tileCoords.x, tileCoords.y))
+	{
+		return 0.f;
+	}
+	// Distance to the walls changes by at most the distance moved from the tile center
+	float clearance = m_wallDistances[tileCoords.x + tileCoords.y * m_dimensions.x] - GetDistance2D(position, GetTileCenter(tileCoords.x, tileCoords.y));
+	return (clearance > 0.f) ? clearance : 0.f;
+}
+
+bool Map::IsPositionClearOfWalls(Vec2 const& position, float radius) const
+{
+	return radius + WALL_CLEARANCE_EPSILON < GetWallClearance(position);
+}
+
@@ -1,13 +1,80 @@
 #pragma once
 #include "Game/GameCommon.hpp"
 #include "Game/Tile.hpp"
+#include "Game/ActorSpatialGrid.hpp"
+#include "Game/ActorPhysicsStore.hpp"
+#include "Game/ActorNarrowphase.hpp"
+#include "Game/TileBitGrid.hpp"
+#include "Game/NavFieldCache.hpp"
+#include "Game/TileDistanceGrid.hpp"
+#include "Game/TileVisibilitySet.hpp"
+#include "Game/FlowFieldBuilder.hpp"
+#include "Game/NavSectorGraph.hpp"
+#include "Game/ChaseFieldCache.hpp"
+#include "Game/BackgroundJob.hpp"
+#include "Game/TileHeatSpread.hpp"
+#include "Game/TileRegionGrid.hpp"
+#include "Game/FlowFieldSampler.hpp"
+#include "Game/SpatialQuerySystem.hpp"
+#include "Game/ActorPool.hpp"
 #include "Engine/Math/IntVec2.hpp"
 #include "Engine/Core/Vertex_PCUTBN.hpp"
 
-class TileHeatMap;
-class TileVectorField;
+class TileDistanceGrid;
+class TileDirectionGrid;
+class WorkerPool;
+class VoxelRayBatch;
+class AI;
 struct RaycastResult2D;
+struct RaycastResult3D;
 
+//-----------------------------------------------------------------------------------------------
+enum class ActorBroadphaseMode
+{
+	BRUTE_FORCE,
+	UNIFORM_GRID,
+};
+
+enum class ActorNarrowphaseMode
+{
+	SCALAR,
+	BATCHED,
+	JACOBI,
+};
+
+enum class ActorRaycastMode
+{
+	BRUTE_FORCE,	// walls, floor/ceiling and every actor tested separately
+	TRAVERSAL,		// one tile walk testing walls and the actors bucketed in each visited tile
+};
+
+enum class ExposureVisibilityMode
+{
+	RAYCAST,	// one voxel raycast from each player to every reachable tile
+	SHADOWCAST,	// recursive shadowcasting bounded to the sight range
+};
+
+enum class NavUpdateMode
+{
+	BLOCKING,			// rebuilt inside UpdateNavGrids on the worker pool
+	BACKGROUND_THREAD,	// rebuilt into the back buffers on a background thread
+	TIME_SLICED,		// rebuilt into the back buffers on the main thread, a few microseconds per frame
+};
+
+enum class NavBuildStage // time sliced nav build, in order
+{
+	IDLE,
+	CLEAR_EXPOSURE,
+	MARK_EXPOSED,
+	SPREAD_EXPOSED,
+	MARK_HIDDEN,
+	SPREAD_HIDDEN,
+	LOAD_FLOW,
+	BUILD_FLOW,
+	DONE,
+};
+
+//-----------------------------------------------------------------------------------------------
 class Map
 {
 public:
@@ -15,7 +82,9 @@ public:
 	~Map();
 
 	void CreateTiles();
+	void CreateWallDistanceField();
 	void CreateNavGrids();
+	void CreateTileVisibilitySet();
 
 	void CreateGeometry();
 	void AddGeometryForWall(AABB3 const& bounds, AABB2 const& UVs);
@@ -31,24 +100,74 @@ public:
 	IntVec2 GetCoordsForWorldPos(float x, float y) const;
 	bool IsTileSolid(int x, int y) const;
 	Vec2 GetTileCenter(int tileX, int tileY) const;
+	float GetWallClearance(Vec2 const& position) const; // conservative distance to the nearest solid tile, 0 outside the map
+	bool IsPositionClearOfWalls(Vec2 const& position, float radius) const;
 
 	void Update();
 	void UpdateActors();
+	void UpdateFleeSteering();
+	void ResolveSpatialQueries();
+	void UpdateActorPhysics();
 	void CollideActors();
+	void CollideActorsBruteForce();
+	void CollideActorsUsingGrid();
+	void CollideActorPairsBatched();
+	void CollideActorPairsJacobi();
 	void CollideActor(Actor* actorA, Actor* actorB);
+	bool CanActorsCollide(Actor const* actorA, Actor const* actorB) const;
 	void CollideActorsWithMap();
 	void CollideActorWithMap(Actor* actor);
+	void CopyActorPhysicsToActors();
 	void CheckAndSpawnPlayers();
 
 	void UpdateNavGrids();
-	void UpdateExposureMap();
-	void UpdateFlowField();
+	void UpdateNavGridsDeferred(std::vector<IntVec2> const& playerTiles);
+	bool IsNavBuildBusy() const;
+	bool TryCollectNavBuild();
+	TileDirectionGrid* GetNavCacheFlowField() const; // null for lazy flow fields, the cache then keeps exposure maps only
+	void StartNavBuild();
+	void StepNavBuild();
+	void RunNavBuildUnit();
+	void FinishNavBuildRows(int endTileY, NavBuildStage nextStage);
+	void SetNavBuildStage(NavBuildStage stage);
+	void GetPlayerNavKey(std::vector<IntVec2>& out_playerTiles) const; // sorted tile coords of every player actor
+	int GetNavAgeInFrames() const;
+	// The exposure and flow builds write only their arguments and scratch owned by the nav job, so they can run off the main thread
+	void UpdateExposureMap(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, WorkerPool* workerPool);
+	void ClearExposureRows(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, int beginTileY, int endTileY) const;
+	void MarkHiddenRows(TileDistanceGrid& exposureMap, int beginTileY, int endTileY) const;
+	void MarkExposedTiles(std::vector<IntVec2> const& playerTiles, TileDistanceGrid& exposureMap, WorkerPool* workerPool);
+	int BeginMarkExposedTiles(std::vector<IntVec2> const& playerTiles); // sizes the per-task tile lists, returns the number of visibility tasks
+	void MarkExposedTilesTask(std::vector<IntVec2> const& playerTiles, int taskIndex); // lists the tiles the task sees in m_exposedTaskTiles
+	void MarkExposedTilesRaycast(std::vector<IntVec2> const& playerTiles, int taskIndex);
+	void MarkExposedTilesShadowcast(std::vector<IntVec2> const& playerTiles, int taskIndex);
+	void WriteExposedTiles(TileDistanceGrid& exposureMap, int taskIndex) const;
+	void UpdateFlowField(TileDistanceGrid const& exposureMap, TileDirectionGrid& flowField, WorkerPool* workerPool);
+	void UpdateNavSectorCosts(std::vector<IntVec2> const& playerTiles);
+	void BuildActiveNavSectors();
+	void BuildNavSector(int sectorIndex);
+	void ResetNavSector(int sectorIndex);
+	void RefreshFlowFieldSamplerTiles(IntVec2 const& minTile, IntVec2 const& maxTile); // sector changes, m_flowFieldVersion is for whole-field changes
+	bool CanTileSeeTile(IntVec2 const& fromTile, IntVec2 const& toTile) const; // center to center, baked PVS lookup when available
+	bool RaycastTileToTile(IntVec2 const& fromTile, IntVec2 const& toTile) const; // exact, ignores the PVS
 	RaycastResult2D FastVoxelRaycast(Vec2 rayStart, Vec2 rayForwardNormal, float rayLength) const;
-	void SpreadDistanceMapHeat(TileHeatMap& distanceMap, float startSearchValue, float heatSpreadStep = 1.f);
-	void SpreadDistanceMapHeatOnReachableMap(TileHeatMap& distanceMap, float startSearchValue, float heatSpreadStep = 1.f);
+	void FastVoxelRaycastSegments(std::vector<Vec2> const& rayStarts, std::vector<Vec2> const& rayEnds, std::vector<RaycastResult2D>& out_results) const; // start to end, 4 rays at a time
+	void SpreadDistanceMapHeat(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep = 1.f) const;
+	void SpreadDistanceMapHeatOnReachableMap(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep = 1.f) const;
+	void SpreadDistanceMapHeatThroughTiles(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep, TileBitGrid const& blockedTiles) const;
 	bool IsTileUnreachable(int tileX, int tileY) const;
-	Vec2 GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos) const;
-	Vec2 GetSafeValueFromFlowField(IntVec2 tileCoords) const;
+	int GetTileRegion(int tileX, int tileY) const; // NO_REGION for solid tiles and outside the map
+	bool AreTilesConnected(IntVec2 const& tileA, IntVec2 const& tileB) const; // walkable from one to the other
+	Vec2 GetBilinearInterpResultFromWorldPos(Vec2 const& worldPos); // flee flow field, evaluates the tiles it reads in lazy mode
+	void EvaluateFlowTilesAround(Vec2 const& worldPos); // lazy mode, the 2x2 tiles a bilinear sample at worldPos reads
+	Vec2 GetBilinearInterpResultFromWorldPos(TileDirectionGrid const& flowField, Vec2 const& worldPos) const;
+	Vec2 GetSafeValueFromFlowField(TileDirectionGrid const& flowField, IntVec2 tileCoords) const;
+
+	// Shared chase fields, one build per goal no matter how many actors follow it
+	int AcquireChaseField(std::vector<IntVec2> const& goalTiles); // returns a field id, release it when done
+	void ReleaseChaseField(int fieldId);
+	Vec2 GetChaseDirectionFromWorldPos(int fieldId, Vec2 const& worldPos) const;
+	void BuildChaseField(std::vector<IntVec2> const& goalTiles, TileDirectionGrid& out_flowField);
 
 	void Render() const;
 	void RenderStatics() const;
@@ -61,16 +180,23 @@ public:
 	void RenderScreen() const;
 	void RenderScreenDebug() const;
 
-	RaycastResultWithActor RaycastAll(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner = nullptr) const; // ignore self?
+	RaycastResultWithActor RaycastAll(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner = nullptr, RaycastResultWithActor const* worldXYResult = nullptr) const; // ignore self? worldXYResult from RaycastWorldXYBatch
 	RaycastResultWithActor RaycastWorldXY(Vec3 const& start, Vec3 const& direction, float distance) const; 
+	void RaycastWorldXYBatch(Vec3 const& start, std::vector<Vec3> const& directions, float distance, VoxelRayBatch& rayBatch, std::vector<RaycastResultWithActor>& out_results) const; // 4 rays at a time, rayBatch is caller scratch
+	void ClipRayToMapBounds(Vec3 const& start, Vec3 const& direction, float& out_minDist, float& out_maxDist) const; // where IsPositionInBounds holds along the ray
 	RaycastResultWithActor RaycastWorldZ(Vec3 const& start, Vec3 const& direction, float distance) const;
 	RaycastResultWithActor RaycastWorldActors(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner = nullptr) const;
+	RaycastResultWithActor RaycastAllTraversal(Vec3 const& start, Vec3 const& direction, float distance, Actor* owner, RaycastResultWithActor const* worldXYResult) const;
+	RaycastResult3D RaycastVsActorSlot(Vec3 const& start, Vec3 const& direction, float distance, int actorIndex) const;
+	bool IsActorRaycastTarget(int actorIndex, Actor const* owner) const; // alive, collides, not the owner or its projectiles
+	void UpdateActorRaycastGrid() const; // rebuilt on the first raycast after actors moved or spawned
 
 	void DeleteDestroyedActors();
 	Actor* SpawnActor(SpawnInfo const& spawnInfo);
+	Actor* SpawnActor(SpawnInfo const& spawnInfo, ActorDefinition const* definition); // spawnInfo.m_actor is ignored
 	void SpawnPlayer(int playerIndex);
+	int ChoosePlayerSpawnPoint() const; // index into m_spawnPoints, by the regions demons are in
 	Actor* GetActorByHandle(ActorHandle const& handle) const;
-	Actor* GetClosestVisibleEnemy(Actor* self); // AI search opposite faction actor,using its
 	
 	void DebugPossessNext(Player* playerController);
 	void OnPlayerDie();
@@ -81,11 +207,16 @@ public:
 
 public:
 	Game* m_game = nullptr; // g_theGame
-	std::vector<Actor*> m_allActors;
+	std::vector<Actor*> m_allActors; // by slot (ActorHandle::GetIndex()), nullptr for free slots
+	std::vector<Actor*> m_liveActors; // every actor packed without holes, for loops that do not need the slot
+	ActorPhysicsStore m_actorPhysics; // same slots as m_allActors
+	SpatialQuerySystem m_spatialQueries; // resolved after the actor update
+	ActorPool m_actorPool; // memory for actors and their AI controllers, reserved from the definitions
 
 
 protected:
-	unsigned int m_currentUid = 0;
+	std::vector<unsigned int> m_actorSlotGenerations; // bumped when the slot's actor is deleted
+	std::vector<int> m_freeActorSlots;
 
 	std::vector<SpawnInfo> m_spawnPoints;
 
@@ -102,8 +233,76 @@ protected:
 
 	SpriteSheet* m_spriteSheet = nullptr;
 
-	TileHeatMap* m_reachableMap = nullptr; // represent the place actor can reach, not is solid
-	TileHeatMap* m_exposureMap = nullptr;
-	TileVectorField* m_flowField = nullptr;
+	TileBitGrid m_solidTiles;		// set = solid, border is solid
+	TileBitGrid m_unreachableTiles;	// set = unreachable, border is unreachable
+	TileRegionGrid m_tileRegions;	// 4-connected regions of non-solid tiles
+	std::vector<unsigned char> m_isRegionReachable; // regions with a spawn point
+	std::vector<float> m_wallDistances; // distance from each tile center to the nearest solid tile bounds, 0 for solid tiles
+	TileVisibilitySet m_tileVisibility; // only built when the map definition has a pvsRadius
+	double m_tileVisibilityBuildMilliseconds = 0.0;
+
+	TileDistanceGrid* m_exposureMap = nullptr;	// front buffer, what AI reads
+	TileDirectionGrid* m_flowField = nullptr;
+	TileDistanceGrid* m_backExposureMap = nullptr; // back buffer, written by the nav job and swapped in when it is collected
+	TileDirectionGrid* m_backFlowField = nullptr;
+	FlowFieldBuilder m_flowFieldBuilder;		// used by the nav job
+	FlowFieldBuilder m_chaseFlowFieldBuilder;	// main thread only
+	int m_flowFieldVersion = 0; // bumped whenever the whole front flow field changes, sector builds refresh the sampler directly
+	FlowFieldSampler m_flowFieldSampler; // padded copy of the front flow field for batched steering
+	int m_flowFieldSamplerVersion = -1;
+	std::vector<AI*> m_fleeingAIs;
+	std::vector<float> m_fleePositionsX;
+	std::vector<float> m_fleePositionsY;
+	std::vector<float> m_fleeDirectionsX;
+	std::vector<float> m_fleeDirectionsY;
+	bool m_isFlowFieldLazy = false; // flee directions computed per tile when sampled instead of for the whole map
+	std::vector<int> m_flowTileVersions; // lazy mode, m_flowFieldVersion each tile was last evaluated for
+	int m_numLazyFlowTiles = 0; // tiles evaluated for the current flow field version
+	int m_lazyFlowCountVersion = -1;
+	NavSectorGraph m_navSectors; // only built when the map definition has a navSectorSize
+	TileBitGrid m_exposedTiles; // sector nav only, set = seen by a player
+	std::vector<IntVec2> m_exposedTileList;
+	std::vector<float> m_navPortalCosts; // estimated distance from each portal to the nearest unexposed tile, -1 = none
+	std::vector<unsigned char> m_isNavSectorBuilt;
+	std::vector<int> m_builtNavSectors;
+	std::vector<float> m_navSectorValues; // BuildNavSector scratch, sized for the largest sector plus its ring
+	std::vector<int> m_navSectorDistances;
+	std::vector<int> m_navSectorCurrentLevelTiles;
+	std::vector<int> m_navSectorNextLevelTiles;
+	std::vector<IntVec2> m_navSectorPortalSeeds;
+	std::vector<IntVec2> m_navKey; // player tiles the current fields were built for
+	bool m_hasNavKey = false;
+	NavUpdateMode m_navUpdateMode = NavUpdateMode::BACKGROUND_THREAD;
+	BackgroundJob m_navJob;
+	NavBuildStage m_navBuildStage = NavBuildStage::IDLE;
+	int m_navBuildCursor = 0; // next row or visibility task of the current stage
+	int m_navBuildNumTasks = 0;
+	TileHeatSpread m_navBuildSpread;
+	float m_navSliceMicroseconds = 1000.f;
+	std::vector<IntVec2> m_navJobKey; // player tiles the back buffer is being built for
+	int m_navJobFrame = 0;
+	int m_navFrame = 0;		// number of nav updates so far
+	int m_navKeyFrame = 0;	// last nav update whose player tiles matched m_navKey
+	NavFieldCache m_navFieldCache;
+	ChaseFieldCache m_chaseFields;
+	std::vector<IntVec2> m_chaseGoalScratch;
+	TileDistanceGrid m_chaseDistanceScratch; // walking distances of the chase field being built
+	ExposureVisibilityMode m_exposureVisibilityMode = ExposureVisibilityMode::SHADOWCAST;
+	std::vector<std::vector<IntVec2>> m_exposedTaskTiles; // per visibility task, tiles it sees, written into the exposure map after the tasks
+
+	ActorBroadphaseMode m_actorBroadphaseMode = ActorBroadphaseMode::UNIFORM_GRID;
+	ActorSpatialGrid m_actorGrid;
+	std::vector<ActorPair> m_actorPairs;
+	ActorNarrowphaseMode m_actorNarrowphaseMode = ActorNarrowphaseMode::BATCHED;
+	int m_numJacobiIterations = 2;
+	ActorNarrowphase m_actorNarrowphase;
+	std::vector<ActorPair> m_actorPairBatch;
+	std::vector<unsigned char> m_actorPairBatchPushed;
+	int m_numActorPairsTested = 0;
+	double m_actorCollisionMilliseconds = 0.0;
+
+	ActorRaycastMode m_actorRaycastMode = ActorRaycastMode::TRAVERSAL;
+	mutable ActorSpatialGrid m_actorRaycastGrid; // every alive actor a ray can hit, by tile
+	mutable bool m_isActorRaycastGridDirty = true;
 };
 
@@ -64,6 +64,8 @@ bool MapDefinition::LoadFromXmlElement(XmlElement const& element)
 	m_spriteSheetTexture = g_theRenderer->CreateOrGetTextureFromFile(texturePath.c_str());
 
 	m_spriteSheetCellCount = ParseXmlAttribute(element, "spriteSheetCellCount", m_spriteSheetCellCount);
+	m_pvsRadius = ParseXmlAttribute(element, "pvsRadius", m_pvsRadius);
+	m_navSectorSize = ParseXmlAttribute(element, "navSectorSize", m_navSectorSize);
 
 	XmlElement const* spawnInfosElement = element.FirstChildElement("SpawnInfos");
 	if (spawnInfosElement)
@@ -90,6 +92,7 @@ bool SpawnInfo::LoadFromXmlElement(XmlElement const& element)
 	m_position = ParseXmlAttribute(element, "position", m_position);
 	m_orientation = ParseXmlAttribute(element, "orientation", m_orientation);
 	m_velocity = ParseXmlAttribute(element, "velocity", m_velocity);
+	m_behavior = ParseXmlAttribute(element, "behavior", m_behavior);
 
 	return true;
 }
@@ -14,6 +14,7 @@ struct SpawnInfo
 	Vec3 m_position;
 	EulerAngles m_orientation;
 	Vec3 m_velocity; // for projectile actors
+	std::string m_behavior; // AI behavior override, empty = the definition's
 
 	bool LoadFromXmlElement(XmlElement const& element);
 };
@@ -33,6 +34,8 @@ struct MapDefinition
 	Shader* m_shader	= nullptr;
 	Texture* m_spriteSheetTexture	= nullptr;
 	IntVec2 m_spriteSheetCellCount	= IntVec2(8,8); // Sprite Sheet Dimensions
+	int m_pvsRadius	= 0; // tile radius of the baked tile visibility set, 0 = raycast every query
+	int m_navSectorSize	= 0; // > 0 = hierarchical nav, fine fields only for sectors with AI actors in them
 	std::vector<SpawnInfo> m_spawnInfos;
 };
 
@@ -0,0 +1,105 @@
+#include "Game/NavFieldCache.hpp"
+
+//-----------------------------------------------------------------------------------------------
+NavFieldCache::Entry::Entry(IntVec2 const& dimensions)
+	: m_exposureMap(dimensions)
+{
+}
+
+//-----------------------------------------------------------------------------------------------
+void NavFieldCache::Initialize(IntVec2 const& dimensions, int capacity)
+{
+	m_dimensions = dimensions;
+	m_capacity = (capacity > 0) ? capacity : 0;
+	m_entries.clear();
+	m_entries.reserve(m_capacity);
+	m_currentTime = 0;
+	m_numHits = 0;
+	m_numMisses = 0;
+}
+
+bool NavFieldCache::Lookup(std::vector<IntVec2> const& key, TileDistanceGrid& out_exposureMap, TileDirectionGrid* out_flowField)
+{
+	m_currentTime++;
+	for (Entry& entry : m_entries)
+	{
+		if (entry.m_key == key)
+		{
+			entry.m_lastUsedTime = m_currentTime;
+			out_exposureMap = entry.m_exposureMap;
+			if (out_flowField != nullptr)
+			{
+				*out_flowField = entry.m_flowField;
+			}
+			m_numHits++;
+			return true;
+		}
+	}
+	m_numMisses++;
+	return false;
+}
+
+void NavFieldCache::Store(std::vector<IntVec2> const& key, TileDistanceGrid const& exposureMap, TileDirectionGrid const* flowField)
+{
+	if (m_capacity == 0)
+	{
+		return;
+	}
+
+	Entry* entry = nullptr;
+	if ((int)m_entries.size() < m_capacity)
+	{
+		m_entries.emplace_back(m_dimensions);
+		entry = &m_entries.back();
+	}
+	else
+	{
+		entry = &m_entries[0];
+		for (Entry& candidate : m_entries)
+		{
+			if (candidate.m_lastUsedTime < entry->m_lastUsedTime)
+			{
+				entry = &candidate;
+			}
+		}
+	}
+
+	entry->m_key = key;
+	entry->m_exposureMap = exposureMap;
+	if (flowField != nullptr)
+	{
+		entry->m_flowField = *flowField;
+	}
+	entry->m_lastUsedTime = m_currentTime;
+}
+
+//-----------------------------------------------------------------------------------------------
+int NavFieldCache::GetNumEntries() const
+{
+	return (int)m_entries.size();
+}
+
+int NavFieldCache::GetCapacity() const
+{
+	return m_capacity;
+}
+
+float NavFieldCache::GetHitRate() const
+{
+	int numLookups = m_numHits + m_numMisses;
+	if (numLookups == 0)
+	{
+		return 0.f;
+	}
+	return static_cast<float>(m_numHits) / static_cast<float>(numLookups);
+}
+
+int NavFieldCache::GetMemoryBytes() const
+{
+	int numBytes = 0;
+	for (Entry const& entry : m_entries)
+	{
+		numBytes += entry.m_exposureMap.GetMemoryBytes() + entry.m_flowField.GetMemoryBytes();
+	}
+	return numBytes;
+}
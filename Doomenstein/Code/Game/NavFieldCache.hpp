@@ -0,0 +1,43 @@
+#pragma once
+#include "Game/TileDistanceGrid.hpp"
+#include "Game/TileDirectionGrid.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+// Bounded LRU cache of finished nav fields (exposure map + flow field), keyed by the sorted tile
+// coords of every player. Fields only depend on that key, so a player walking back and forth
+// between tiles gets the earlier result back instead of a rebuild. Capacity 0 disables the cache.
+// A null flow field caches the exposure map alone, for lazy flow fields that are re-evaluated anyway.
+//
+class NavFieldCache
+{
+public:
+	void Initialize(IntVec2 const& dimensions, int capacity);
+
+	bool Lookup(std::vector<IntVec2> const& key, TileDistanceGrid& out_exposureMap, TileDirectionGrid* out_flowField); // counts a hit or a miss
+	void Store(std::vector<IntVec2> const& key, TileDistanceGrid const& exposureMap, TileDirectionGrid const* flowField); // evicts the least recently used entry when full
+
+	int GetNumEntries() const;
+	int GetCapacity() const;
+	float GetHitRate() const; // [0, 1], 0 before the first lookup
+	int GetMemoryBytes() const; // grids of every entry
+
+private:
+	struct Entry
+	{
+		Entry(IntVec2 const& dimensions);
+
+		std::vector<IntVec2> m_key;
+		TileDistanceGrid m_exposureMap;
+		TileDirectionGrid m_flowField; // empty when only exposure maps are stored
+		unsigned int m_lastUsedTime = 0;
+	};
+
+	IntVec2 m_dimensions;
+	int m_capacity = 0;
+	std::vector<Entry> m_entries;
+	unsigned int m_currentTime = 0;
+	int m_numHits = 0;
+	int m_numMisses = 0;
+};
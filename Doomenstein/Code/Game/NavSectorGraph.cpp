@@ -0,0 +1,249 @@
+#include "Game/NavSectorGraph.hpp"
+#include "Game/TileBitGrid.hpp"
+#include <functional>
+#include <queue>
+
+//-----------------------------------------------------------------------------------------------
+IntVec2 NavPortal::GetCenterTile(int sectorIndex) const
+{
+	return GetCrossingTile(m_numCrossings / 2, sectorIndex);
+}
+
+IntVec2 NavPortal::GetCrossingTile(int crossingIndex, int sectorIndex) const
+{
+	IntVec2 tileA = IntVec2(m_firstTileA.x + m_runStep.x * crossingIndex, m_firstTileA.y + m_runStep.y * crossingIndex);
+	if (sectorIndex == m_sectorIndexA)
+	{
+		return tileA;
+	}
+	return IntVec2(tileA.x + m_crossStep.x, tileA.y + m_crossStep.y);
+}
+
+//-----------------------------------------------------------------------------------------------
+void NavSectorGraph::Build(TileBitGrid const& unreachableTiles, int sectorSize)
+{
+	m_unreachableTiles = &unreachableTiles;
+	m_dimensions = unreachableTiles.GetDimensions();
+	m_sectorSize = sectorSize;
+	m_portals.clear();
+	m_sectorPortalStarts.clear();
+	m_sectorPortals.clear();
+	m_portalEdgeStarts.clear();
+	m_portalEdges.clear();
+	if (sectorSize <= 0)
+	{
+		m_sectorSize = 0;
+		return;
+	}
+	m_numSectors = IntVec2((m_dimensions.x + sectorSize - 1) / sectorSize, (m_dimensions.y + sectorSize - 1) / sectorSize);
+
+	// Portals, one sector border segment at a time so no run spans two sectors
+	for (int sectorY = 0; sectorY < m_numSectors.y; ++sectorY)
+	{
+		for (int sectorX = 0; sectorX < m_numSectors.x; ++sectorX)
+		{
+			IntVec2 minTile;
+			IntVec2 maxTile;
+			GetSectorBounds(sectorX + sectorY * m_numSectors.x, minTile, maxTile);
+			if (maxTile.x + 1 < m_dimensions.x)
+			{
+				AddPortalsAlongBorder(IntVec2(maxTile.x, minTile.y), IntVec2(0, 1), IntVec2(1, 0), maxTile.y - minTile.y + 1);
+			}
+			if (maxTile.y + 1 < m_dimensions.y)
+			{
+				AddPortalsAlongBorder(IntVec2(minTile.x, maxTile.y), IntVec2(1, 0), IntVec2(0, 1), maxTile.x - minTile.x + 1);
+			}
+		}
+	}
+
+	// Portals per sector
+	int numSectors = GetNumSectors();
+	int numPortals = GetNumPortals();
+	m_sectorPortalStarts.assign(numSectors + 1, 0);
+	for (NavPortal const& portal : m_portals)
+	{
+		m_sectorPortalStarts[portal.m_sectorIndexA + 1]++;
+		m_sectorPortalStarts[portal.m_sectorIndexB + 1]++;
+	}
+	for (int sectorIndex = 0; sectorIndex < numSectors; ++sectorIndex)
+	{
+		m_sectorPortalStarts[sectorIndex + 1] += m_sectorPortalStarts[sectorIndex];
+	}
+	m_sectorPortals.resize(m_sectorPortalStarts[numSectors]);
+	std::vector<int> sectorCursors(m_sectorPortalStarts.begin(), m_sectorPortalStarts.end() - 1);
+	for (int portalIndex = 0; portalIndex < numPortals; ++portalIndex)
+	{
+		m_sectorPortals[sectorCursors[m_portals[portalIndex].m_sectorIndexA]++] = portalIndex;
+		m_sectorPortals[sectorCursors[m_portals[portalIndex].m_sectorIndexB]++] = portalIndex;
+	}
+
+	// Edges between the portals of each sector, walking distance between center crossings plus the step across
+	std::vector<std::vector<PortalEdge>> edgesPerPortal(numPortals);
+	std::vector<IntVec2> seedTiles;
+	std::vector<int> distances;
+	for (int sectorIndex = 0; sectorIndex < numSectors; ++sectorIndex)
+	{
+		IntVec2 minTile;
+		IntVec2 maxTile;
+		GetSectorBounds(sectorIndex, minTile, maxTile);
+		int sectorWidth = maxTile.x - minTile.x + 1;
+		for (int startIndex = m_sectorPortalStarts[sectorIndex]; startIndex < m_sectorPortalStarts[sectorIndex + 1]; ++startIndex)
+		{
+			int fromPortalIndex = m_sectorPortals[startIndex];
+			seedTiles.clear();
+			seedTiles.push_back(m_portals[fromPortalIndex].GetCenterTile(sectorIndex));
+			ComputeSectorDistances(sectorIndex, seedTiles, distances);
+
+			for (int endIndex = m_sectorPortalStarts[sectorIndex]; endIndex < m_sectorPortalStarts[sectorIndex + 1]; ++endIndex)
+			{
+				int toPortalIndex = m_sectorPortals[endIndex];
+				IntVec2 toTile = m_portals[toPortalIndex].GetCenterTile(sectorIndex);
+				int distance = distances[(toTile.x - minTile.x) + (toTile.y - minTile.y) * sectorWidth];
+				if (toPortalIndex != fromPortalIndex && distance >= 0)
+				{
+					edgesPerPortal[fromPortalIndex].push_back(PortalEdge{ toPortalIndex, static_cast<float>(distance + 1) });
+				}
+			}
+		}
+	}
+	m_portalEdgeStarts.assign(numPortals + 1, 0);
+	for (int portalIndex = 0; portalIndex < numPortals; ++portalIndex)
+	{
+		m_portalEdgeStarts[portalIndex + 1] = m_portalEdgeStarts[portalIndex] + (int)edgesPerPortal[portalIndex].size();
+		m_portalEdges.insert(m_portalEdges.end(), edgesPerPortal[portalIndex].begin(), edgesPerPortal[portalIndex].end());
+	}
+}
+
+void NavSectorGraph::AddPortalsAlongBorder(IntVec2 const& firstTileA, IntVec2 const& runStep, IntVec2 const& crossStep, int runLength)
+{
+	int sectorIndexA = GetSectorIndex(firstTileA.x, firstTileA.y);
+	int sectorIndexB = GetSectorIndex(firstTileA.x + crossStep.x, firstTileA.y + crossStep.y);
+	NavPortal portal;
+	for (int runIndex = 0; runIndex <= runLength; ++runIndex)
+	{
+		IntVec2 tileA = IntVec2(firstTileA.x + runStep.x * runIndex, firstTileA.y + runStep.y * runIndex);
+		bool isOpen = runIndex < runLength
+			&& !m_unreachableTiles->IsSet(tileA.x, tileA.y)
+			&& !m_unreachableTiles->IsSet(tileA.x + crossStep.x, tileA.y + crossStep.y);
+		if (isOpen && portal.m_numCrossings == 0)
+		{
+			portal.m_sectorIndexA = sectorIndexA;
+			portal.m_sectorIndexB = sectorIndexB;
+			portal.m_firstTileA = tileA;
+			portal.m_runStep = runStep;
+			portal.m_crossStep = crossStep;
+		}
+		if (isOpen)
+		{
+			portal.m_numCrossings++;
+		}
+		else if (portal.m_numCrossings > 0)
+		{
+			m_portals.push_back(portal);
+			portal.m_numCrossings = 0;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+int NavSectorGraph::GetSectorIndex(int tileX, int tileY) const
+{
+	return (tileX / m_sectorSize) + (tileY / m_sectorSize) * m_numSectors.x;
+}
+
+void NavSectorGraph::GetSectorBounds(int sectorIndex, IntVec2& out_minTile, IntVec2& out_maxTile) const
+{
+	out_minTile = IntVec2((sectorIndex % m_numSectors.x) * m_sectorSize, (sectorIndex / m_numSectors.x) * m_sectorSize);
+	out_maxTile = IntVec2(out_minTile.x + m_sectorSize - 1, out_minTile.y + m_sectorSize - 1);
+	out_maxTile.x = (out_maxTile.x < m_dimensions.x) ? out_maxTile.x : m_dimensions.x - 1;
+	out_maxTile.y = (out_maxTile.y < m_dimensions.y) ? out_maxTile.y : m_dimensions.y - 1;
+}
+
+void NavSectorGraph::GetSectorPortals(int sectorIndex, int const*& out_begin, int const*& out_end) const
+{
+	out_begin = m_sectorPortals.data() + m_sectorPortalStarts[sectorIndex];
+	out_end = m_sectorPortals.data() + m_sectorPortalStarts[sectorIndex + 1];
+}
+
+//-----------------------------------------------------------------------------------------------
+void NavSectorGraph::ComputeSectorDistances(int sectorIndex, std::vector<IntVec2> const& seedTiles, std::vector<int>& out_distances) const
+{
+	IntVec2 minTile;
+	IntVec2 maxTile;
+	GetSectorBounds(sectorIndex, minTile, maxTile);
+	int sectorWidth = maxTile.x - minTile.x + 1;
+	int sectorHeight = maxTile.y - minTile.y + 1;
+	out_distances.assign(sectorWidth * sectorHeight, -1);
+
+	std::vector<int> frontier;
+	for (IntVec2 const& seedTile : seedTiles)
+	{
+		int localIndex = (seedTile.x - minTile.x) + (seedTile.y - minTile.y) * sectorWidth;
+		if (out_distances[localIndex] < 0)
+		{
+			out_distances[localIndex] = 0;
+			frontier.push_back(localIndex);
+		}
+	}
+
+	IntVec2 directions[4] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0) };
+	for (int frontierIndex = 0; frontierIndex < (int)frontier.size(); ++frontierIndex)
+	{
+		int localIndex = frontier[frontierIndex];
+		int localX = localIndex % sectorWidth;
+		int localY = localIndex / sectorWidth;
+		for (int i = 0; i < 4; ++i)
+		{
+			int neighborX = localX + directions[i].x;
+			int neighborY = localY + directions[i].y;
+			if (neighborX < 0 || neighborY < 0 || neighborX >= sectorWidth || neighborY >= sectorHeight)
+			{
+				continue;
+			}
+			int neighborIndex = neighborX + neighborY * sectorWidth;
+			if (out_distances[neighborIndex] >= 0 || m_unreachableTiles->IsSet(minTile.x + neighborX, minTile.y + neighborY))
+			{
+				continue;
+			}
+			out_distances[neighborIndex] = out_distances[localIndex] + 1;
+			frontier.push_back(neighborIndex);
+		}
+	}
+}
+
+void NavSectorGraph::SolvePortalCosts(std::vector<float> const& portalSeedCosts, std::vector<float>& out_portalCosts) const
+{
+	typedef std::pair<float, int> CostAndPortal;
+	std::priority_queue<CostAndPortal, std::vector<CostAndPortal>, std::greater<CostAndPortal>> openPortals;
+
+	int numPortals = GetNumPortals();
+	out_portalCosts.assign(numPortals, -1.f);
+	for (int portalIndex = 0; portalIndex < numPortals; ++portalIndex)
+	{
+		if (portalSeedCosts[portalIndex] >= 0.f)
+		{
+			out_portalCosts[portalIndex] = portalSeedCosts[portalIndex];
+			openPortals.push(CostAndPortal(portalSeedCosts[portalIndex], portalIndex));
+		}
+	}
+
+	while (!openPortals.empty())
+	{
+		CostAndPortal current = openPortals.top();
+		openPortals.pop();
+		if (current.first > out_portalCosts[current.second])
+		{
+			continue; // stale entry
+		}
+		for (int edgeIndex = m_portalEdgeStarts[current.second]; edgeIndex < m_portalEdgeStarts[current.second + 1]; ++edgeIndex)
+		{
+			PortalEdge const& edge = m_portalEdges[edgeIndex];
+			float cost = current.first + edge.m_cost;
+			if (out_portalCosts[edge.m_portalIndex] < 0.f || cost < out_portalCosts[edge.m_portalIndex])
+			{
+				out_portalCosts[edge.m_portalIndex] = cost;
+				openPortals.push(CostAndPortal(cost, edge.m_portalIndex));
+			}
+		}
+	}
+}
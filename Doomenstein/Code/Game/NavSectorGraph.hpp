@@ -0,0 +1,68 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+class TileBitGrid;
+
+//-----------------------------------------------------------------------------------------------
+struct NavPortal
+{
+	int m_sectorIndexA = -1;	// left or bottom sector
+	int m_sectorIndexB = -1;	// right or top sector
+	IntVec2 m_firstTileA;		// first crossing of the run, in sector A
+	IntVec2 m_runStep;			// (0,1) along a vertical sector border, (1,0) along a horizontal one
+	IntVec2 m_crossStep;		// tile in sector B = tile in sector A + m_crossStep
+	int m_numCrossings = 0;
+
+	IntVec2 GetCenterTile(int sectorIndex) const; // center crossing on the side of the given sector
+	IntVec2 GetCrossingTile(int crossingIndex, int sectorIndex) const;
+};
+
+//-----------------------------------------------------------------------------------------------
+// Coarse navigation layer for large maps. The map is cut into square sectors, every maximal run of
+// reachable tile pairs across a sector border becomes a portal, and portals of the same sector are
+// linked by the walking distance between their center crossings inside that sector. Distances on
+// the portal graph are a sector-level estimate, used to seed the fine per-sector fields at their
+// borders. Built once at load from the reachability bits.
+//
+class NavSectorGraph
+{
+public:
+	void Build(TileBitGrid const& unreachableTiles, int sectorSize);
+
+	bool IsBuilt() const { return m_sectorSize > 0; }
+	int GetSectorSize() const { return m_sectorSize; }
+	int GetNumSectors() const { return m_numSectors.x * m_numSectors.y; }
+	int GetNumPortals() const { return (int)m_portals.size(); }
+	int GetSectorIndex(int tileX, int tileY) const;
+	void GetSectorBounds(int sectorIndex, IntVec2& out_minTile, IntVec2& out_maxTile) const; // inclusive
+	NavPortal const& GetPortal(int portalIndex) const { return m_portals[portalIndex]; }
+	void GetSectorPortals(int sectorIndex, int const*& out_begin, int const*& out_end) const;
+
+	// Walking distance from the seed tiles to every tile of the sector without leaving it, -1 where it can not get to.
+	// out_distances is indexed by the tile's offset from the sector's min tile, row by row
+	void ComputeSectorDistances(int sectorIndex, std::vector<IntVec2> const& seedTiles, std::vector<int>& out_distances) const;
+
+	// Dijkstra over the portal graph, every portal starts at its seed cost (negative = no seed)
+	void SolvePortalCosts(std::vector<float> const& portalSeedCosts, std::vector<float>& out_portalCosts) const;
+
+private:
+	void AddPortalsAlongBorder(IntVec2 const& firstTileA, IntVec2 const& runStep, IntVec2 const& crossStep, int runLength);
+
+private:
+	struct PortalEdge
+	{
+		int m_portalIndex = -1;
+		float m_cost = 0.f;
+	};
+
+	TileBitGrid const*		m_unreachableTiles = nullptr;
+	IntVec2					m_dimensions;
+	int						m_sectorSize = 0;
+	IntVec2					m_numSectors;
+	std::vector<NavPortal>	m_portals;
+	std::vector<int>		m_sectorPortalStarts;	// CSR, numSectors + 1
+	std::vector<int>		m_sectorPortals;
+	std::vector<int>		m_portalEdgeStarts;		// CSR, numPortals + 1
+	std::vector<PortalEdge>	m_portalEdges;
+};
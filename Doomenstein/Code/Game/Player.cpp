@@ -546,16 +546,8 @@ void Player::UpdateFirstPersonInput()
 	m_position = controlledActor->GetEyePosition();
 	m_orientation = controlledActor->m_orientation;
 
-	// Update Closest To Center
-	Actor* nearestEnemy = GetNearestEnemyToCenter();
-	if (nearestEnemy)
-	{
-		m_closestToCenterEnemy = nearestEnemy->m_handle;
-	}
-	else
-	{
-		m_closestToCenterEnemy = ActorHandle::INVALID;
-	}
+	// Update Closest To Center, the result lands after the actor update
+	SubmitNearestEnemyToCenterQuery();
 
 
 	if (m_controllerIndex == KEYBOARD_AND_MOUSE)
@@ -820,7 +812,7 @@ void Player::UpdateRadarScanResult()
 	if (m_map)
 	{
 		//int numActor = (int)m_map->m_allActors.size();
-		for (Actor const* actor : m_map->m_allActors)
+		for (Actor const* actor : m_map->m_liveActors)
 		{
 			if (actor == nullptr || actor->m_isDead)
 			{
@@ -864,17 +856,17 @@ void Player::UnlockTarget()
 	m_targetActorHandle = ActorHandle::INVALID;
 }
 
-Actor* Player::GetNearestEnemyToCenter() const
+void Player::SubmitNearestEnemyToCenterQuery()
 {
 	if (m_map == nullptr)
 	{
-		return nullptr;
+		return;
 	}
 
 	std::vector<Actor*> aliveDemons;
 
 	// Gather all demons
-	for (Actor* actor : m_map->m_allActors)
+	for (Actor* actor : m_map->m_liveActors)
 	{
 		if (actor == nullptr || actor->m_isDead || actor->m_definition->m_faction != Faction::DEMON)
 		{
@@ -885,9 +877,13 @@ Actor* Player::GetNearestEnemyToCenter() const
 	}
 
 
-	// Closest demon to the center of the screen
-	Actor* closestDemon = nullptr;
-	float minDistanceX = 99999.f;
+	// Demons inside the lock-on box, their walls are tested in one query
+	std::vector<ActorHandle> candidateDemons;
+	std::vector<float> candidateViewportXs;
+	std::vector<Vec2> rayStarts;
+	std::vector<Vec2> rayEnds;
+	AABB2 lockOnBox = AABB2(Vec2(0.25f, 0.25f), Vec2(0.75f, 0.75f));
+	Vec2 rayStart = Vec2(m_camera.GetPosition().x, m_camera.GetPosition().y);
 
 	for (Actor* demon : aliveDemons)
 	{
@@ -898,32 +894,43 @@ Actor* Player::GetNearestEnemyToCenter() const
 		{
 			continue;
 		}
-		AABB2 lockOnBox = AABB2(Vec2(0.25f, 0.25f), Vec2(0.75f, 0.75f));
 		if (!lockOnBox.IsPointInside(viewportPos))
 		{
 			continue;
 		}
 
-		// Fast Raycast to check visibility
-		Vec2 rayStart = Vec2(m_camera.GetPosition().x, m_camera.GetPosition().y);
-		Vec2 rayEnd = Vec2(worldPosDemon.x, worldPosDemon.y);
-		Vec2 disp = rayEnd - rayStart;
-		RaycastResult2D result = m_map->FastVoxelRaycast(rayStart, disp.GetNormalized(), disp.GetLength());
-		if (result.m_didImpact)
-		{
-			continue;
-		}
+		candidateDemons.push_back(demon->m_handle);
+		candidateViewportXs.push_back(viewportPos.x);
+		rayStarts.push_back(rayStart);
+		rayEnds.push_back(Vec2(worldPosDemon.x, worldPosDemon.y));
+	}
 
-		// Closest to center , only takes x because y is not so important
-		float distanceX = fabsf(viewportPos.x - 0.5f);
-		if (distanceX < minDistanceX)
+	// Fast Raycast to check visibility
+	Player* self = this;
+	m_map->m_spatialQueries.SubmitWallRaycasts(rayStarts, rayEnds, [self, candidateDemons, candidateViewportXs](SpatialQueryResult const& result)
 		{
-			closestDemon = demon;
-			minDistanceX = distanceX;
-		}
-	}
+			// Closest demon to the center of the screen
+			ActorHandle closestDemon = ActorHandle::INVALID;
+			float minDistanceX = 99999.f;
+
+			for (int candidateIndex = 0; candidateIndex < (int)candidateDemons.size(); ++candidateIndex)
+			{
+				if (result.m_wallRaycasts[candidateIndex].m_didImpact)
+				{
+					continue;
+				}
+
+				// Closest to center , only takes x because y is not so important
+				float distanceX = fabsf(candidateViewportXs[candidateIndex] - 0.5f);
+				if (distanceX < minDistanceX)
+				{
+					closestDemon = candidateDemons[candidateIndex];
+					minDistanceX = distanceX;
+				}
+			}
 
-	return closestDemon;
+			self->m_closestToCenterEnemy = closestDemon;
+		});
 }
 
 void Player::UpdateCamera()
@@ -40,7 +40,7 @@ protected:
 
 	void AttemptLockOn();
 	void UnlockTarget();
-	Actor* GetNearestEnemyToCenter() const;
+	void SubmitNearestEnemyToCenterQuery(); // updates m_closestToCenterEnemy once resolved
 
 	void UpdateCamera();
 	void UpdateAudioListener();
@@ -0,0 +1,203 @@
+#include "Game/SpatialQuerySystem.hpp"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+#include "Game/ActorDefinition.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/Capsule2.hpp"
+
+//-----------------------------------------------------------------------------------------------
+constexpr int QUERIES_PER_TASK = 4;
+
+//-----------------------------------------------------------------------------------------------
+void SpatialQuerySystem::SubmitRaycast(Vec3 const& start, Vec3 const& direction, float distance, ActorHandle const& owner, SpatialQueryCallback const& callback)
+{
+	Query query;
+	query.m_type = SpatialQueryType::RAYCAST;
+	query.m_actor = owner;
+	query.m_start = start;
+	query.m_direction = direction;
+	query.m_distance = distance;
+	query.m_callback = callback;
+	m_pendingQueries.push_back(query);
+}
+
+void SpatialQuerySystem::SubmitWallRaycasts(std::vector<Vec2> const& rayStarts, std::vector<Vec2> const& rayEnds, SpatialQueryCallback const& callback)
+{
+	Query query;
+	query.m_type = SpatialQueryType::WALL_RAYCASTS;
+	query.m_rayStarts = rayStarts;
+	query.m_rayEnds = rayEnds;
+	query.m_callback = callback;
+	m_pendingQueries.push_back(query);
+}
+
+void SpatialQuerySystem::SubmitSector(ActorHandle const& querier, Vec2 const& sectorTip, Vec2 const& sectorForward, float sectorApertureDegrees, float sectorRadius,
+	SpatialQueryCallback const& callback)
+{
+	Query query;
+	query.m_type = SpatialQueryType::SECTOR;
+	query.m_actor = querier;
+	query.m_shapeStart = sectorTip;
+	query.m_shapeEnd = sectorForward;
+	query.m_apertureDegrees = sectorApertureDegrees;
+	query.m_radius = sectorRadius;
+	query.m_callback = callback;
+	m_pendingQueries.push_back(query);
+}
+
+void SpatialQuerySystem::SubmitSectorInSight(ActorHandle const& querier, Vec2 const& sectorTip, Vec2 const& sectorForward, float sectorApertureDegrees, float sectorRadius,
+	Vec3 const& eyePosition, SpatialQueryCallback const& callback)
+{
+	SubmitSector(querier, sectorTip, sectorForward, sectorApertureDegrees, sectorRadius, callback);
+	m_pendingQueries.back().m_start = eyePosition;
+	m_pendingQueries.back().m_isLineOfSightRequired = true;
+}
+
+void SpatialQuerySystem::SubmitCapsule(ActorHandle const& querier, Vec2 const& boneStart, Vec2 const& boneEnd, float radius, SpatialQueryCallback const& callback)
+{
+	Query query;
+	query.m_type = SpatialQueryType::CAPSULE;
+	query.m_actor = querier;
+	query.m_shapeStart = boneStart;
+	query.m_shapeEnd = boneEnd;
+	query.m_radius = radius;
+	query.m_callback = callback;
+	m_pendingQueries.push_back(query);
+}
+
+//-----------------------------------------------------------------------------------------------
+void SpatialQuerySystem::Resolve(Map const& map, WorkerPool* workerPool)
+{
+	double startTime = GetCurrentTimeSeconds();
+
+	// Queries submitted by the callbacks below wait for the next resolve
+	m_resolvingQueries.swap(m_pendingQueries);
+	m_pendingQueries.clear();
+	int numQueries = (int)m_resolvingQueries.size();
+	if ((int)m_results.size() < numQueries)
+	{
+		m_results.resize(numQueries);
+		m_scratches.resize(numQueries);
+	}
+
+	auto resolveQueries = [&](int beginQuery, int endQuery)
+		{
+			for (int queryIndex = beginQuery; queryIndex < endQuery; ++queryIndex)
+			{
+				ResolveQuery(map, m_resolvingQueries[queryIndex], m_scratches[queryIndex], m_results[queryIndex]);
+			}
+		};
+	if (workerPool != nullptr)
+	{
+		workerPool->ParallelFor(numQueries, QUERIES_PER_TASK, resolveQueries);
+	}
+	else
+	{
+		resolveQueries(0, numQueries);
+	}
+
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		if (m_resolvingQueries[queryIndex].m_callback)
+		{
+			m_resolvingQueries[queryIndex].m_callback(m_results[queryIndex]);
+		}
+	}
+	m_resolvingQueries.clear();
+
+	m_numResolvedQueries = numQueries;
+	m_resolveMilliseconds = (GetCurrentTimeSeconds() - startTime) * 1000.0;
+}
+
+void SpatialQuerySystem::Clear()
+{
+	m_pendingQueries.clear();
+}
+
+//-----------------------------------------------------------------------------------------------
+void SpatialQuerySystem::ResolveQuery(Map const& map, Query const& query, QueryScratch& scratch, SpatialQueryResult& out_result) const
+{
+	out_result.m_wallRaycasts.clear();
+	out_result.m_actors.clear();
+
+	switch (query.m_type)
+	{
+	case SpatialQueryType::RAYCAST:
+		out_result.m_raycast = map.RaycastAll(query.m_start, query.m_direction, query.m_distance, map.GetActorByHandle(query.m_actor));
+		break;
+	case SpatialQueryType::WALL_RAYCASTS:
+		map.FastVoxelRaycastSegments(query.m_rayStarts, query.m_rayEnds, out_result.m_wallRaycasts);
+		break;
+	case SpatialQueryType::SECTOR:
+	case SpatialQueryType::CAPSULE:
+		GatherOpposingActors(map, query, scratch, out_result.m_actors);
+		break;
+	default:
+		break;
+	}
+}
+
+void SpatialQuerySystem::GatherOpposingActors(Map const& map, Query const& query, QueryScratch& scratch, std::vector<ActorHandle>& out_actors) const
+{
+	Actor const* querier = map.GetActorByHandle(query.m_actor);
+	if (querier == nullptr)
+	{
+		return;
+	}
+
+	Capsule2 capsule = Capsule2(query.m_shapeStart, query.m_shapeEnd, query.m_radius);
+	std::vector<Actor const*>& candidates = scratch.m_candidates;
+	candidates.clear();
+	for (Actor const* actor : map.m_liveActors)
+	{
+		if (actor->m_isDead)
+		{
+			continue;
+		}
+		// only opposing faction
+		if (!querier->IsOpposingFaction(actor->m_definition->m_faction))
+		{
+			continue;
+		}
+
+		Vec2 actorPosXY = Vec2(actor->m_position.x, actor->m_position.y);
+		bool isInside = (query.m_type == SpatialQueryType::SECTOR) ?
+			IsPointInsideDirectedSector2D(actorPosXY, query.m_shapeStart, query.m_shapeEnd, query.m_apertureDegrees, query.m_radius) :
+			IsPointInsideCapsule2D(actorPosXY, capsule);
+		if (isInside)
+		{
+			candidates.push_back(actor);
+		}
+	}
+
+	if (!query.m_isLineOfSightRequired)
+	{
+		for (Actor const* actor : candidates)
+		{
+			out_actors.push_back(actor->m_handle);
+		}
+		return;
+	}
+
+	// Every candidate gets a wall ray from the eye, all traced in one batch
+	std::vector<Vec3>& sightDirections = scratch.m_sightDirections;
+	sightDirections.clear();
+	for (Actor const* actor : candidates)
+	{
+		sightDirections.push_back((actor->m_position - querier->m_position).GetNormalized());
+	}
+	std::vector<RaycastResultWithActor> const& results = scratch.m_sightResults;
+	map.RaycastWorldXYBatch(query.m_start, sightDirections, query.m_radius, scratch.m_rayBatch, scratch.m_sightResults);
+	for (int candidateIndex = 0; candidateIndex < (int)candidates.size(); ++candidateIndex)
+	{
+		Vec3 disp = candidates[candidateIndex]->m_position - querier->m_position;
+		RaycastResultWithActor const& result = results[candidateIndex];
+		float distanceXYSquared = Vec2(disp.x, disp.y).GetLengthSquared();
+		if (!result.m_didImpact || result.m_impactDist * result.m_impactDist > distanceXYSquared)
+		{
+			out_actors.push_back(candidates[candidateIndex]->m_handle);
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Game/GameCommon.hpp"
+#include "Game/ActorHandle.hpp"
+#include "Game/VoxelRayBatch.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Math/RaycastUtils.hpp"
+#include <functional>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+enum class SpatialQueryType
+{
+	RAYCAST,		// walls, floor/ceiling and actors, same as Map::RaycastAll
+	WALL_RAYCASTS,	// xy segments against walls only, same as Map::FastVoxelRaycastSegments
+	SECTOR,			// opposing actors inside a directed sector, optionally only those in line of sight
+	CAPSULE,		// opposing actors inside a 2D capsule
+};
+
+//-----------------------------------------------------------------------------------------------
+struct SpatialQueryResult
+{
+	RaycastResultWithActor			m_raycast;		// RAYCAST
+	std::vector<RaycastResult2D>	m_wallRaycasts;	// WALL_RAYCASTS, one per segment
+	std::vector<ActorHandle>		m_actors;		// SECTOR and CAPSULE, in Map::m_liveActors order
+};
+
+typedef std::function<void(SpatialQueryResult const& result)> SpatialQueryCallback;
+
+//-----------------------------------------------------------------------------------------------
+// Deferred map queries. Callers submit during the actor update, Map resolves everything once per
+// tick on the worker pool while nothing in the map changes, then runs the callbacks on the main
+// thread in submission order. Callbacks look actors up again by handle before touching them; the
+// queries they submit themselves are resolved next tick.
+//
+class SpatialQuerySystem
+{
+public:
+	void SubmitRaycast(Vec3 const& start, Vec3 const& direction, float distance, ActorHandle const& owner, SpatialQueryCallback const& callback);
+	void SubmitWallRaycasts(std::vector<Vec2> const& rayStarts, std::vector<Vec2> const& rayEnds, SpatialQueryCallback const& callback);
+	void SubmitSector(ActorHandle const& querier, Vec2 const& sectorTip, Vec2 const& sectorForward, float sectorApertureDegrees, float sectorRadius,
+		SpatialQueryCallback const& callback);
+	void SubmitSectorInSight(ActorHandle const& querier, Vec2 const& sectorTip, Vec2 const& sectorForward, float sectorApertureDegrees, float sectorRadius,
+		Vec3 const& eyePosition, SpatialQueryCallback const& callback); // walls block actors nearer than sectorRadius, like the old AI sight check
+	void SubmitCapsule(ActorHandle const& querier, Vec2 const& boneStart, Vec2 const& boneEnd, float radius, SpatialQueryCallback const& callback);
+
+	void Resolve(Map const& map, WorkerPool* workerPool);
+	void Clear(); // drops pending queries without running their callbacks
+
+	int GetNumPendingQueries() const { return (int)m_pendingQueries.size(); }
+	int GetNumResolvedQueries() const { return m_numResolvedQueries; } // in the last Resolve
+	double GetResolveMilliseconds() const { return m_resolveMilliseconds; }
+
+private:
+	struct Query
+	{
+		SpatialQueryType m_type = SpatialQueryType::RAYCAST;
+		ActorHandle m_actor; // raycast owner, or the querier whose opposing factions are gathered
+		Vec3 m_start;
+		Vec3 m_direction;
+		float m_distance = 0.f;
+		Vec2 m_shapeStart;	// sector tip or capsule bone start
+		Vec2 m_shapeEnd;	// sector forward or capsule bone end
+		float m_apertureDegrees = 0.f;
+		float m_radius = 0.f;
+		bool m_isLineOfSightRequired = false;
+		std::vector<Vec2> m_rayStarts;
+		std::vector<Vec2> m_rayEnds;
+		SpatialQueryCallback m_callback;
+	};
+
+	// Working memory of one query slot, kept across ticks like the results so resolving does not allocate
+	struct QueryScratch
+	{
+		std::vector<Actor const*>			m_candidates;
+		std::vector<Vec3>					m_sightDirections;
+		std::vector<RaycastResultWithActor>	m_sightResults;
+		VoxelRayBatch						m_rayBatch;
+	};
+
+	void ResolveQuery(Map const& map, Query const& query, QueryScratch& scratch, SpatialQueryResult& out_result) const;
+	void GatherOpposingActors(Map const& map, Query const& query, QueryScratch& scratch, std::vector<ActorHandle>& out_actors) const;
+
+private:
+	std::vector<Query>				m_pendingQueries;
+	std::vector<Query>				m_resolvingQueries;
+	std::vector<SpatialQueryResult>	m_results;
+	std::vector<QueryScratch>		m_scratches; // parallel to m_results
+	int								m_numResolvedQueries = 0;
+	double							m_resolveMilliseconds = 0.0;
+};
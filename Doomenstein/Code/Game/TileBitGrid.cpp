@@ -0,0 +1,154 @@
+#include "Game/TileBitGrid.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------------------------
+int CountTrailingZeroBits(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long bitIndex = 0;
+	_BitScanForward64(&bitIndex, word);
+	return (int)bitIndex;
+#elif defined(_MSC_VER)
+	unsigned long bitIndex = 0;
+	if (_BitScanForward(&bitIndex, (unsigned long)(word & 0xFFFFFFFFu)))
+	{
+		return (int)bitIndex;
+	}
+	_BitScanForward(&bitIndex, (unsigned long)(word >> 32));
+	return (int)bitIndex + 32;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+int CountSetBits(uint64_t word)
+{
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (int)((word * 0x0101010101010101ull) >> 56);
+}
+
+//-----------------------------------------------------------------------------------------------
+void TileBitGrid::Initialize(IntVec2 const& dimensions, bool borderValue)
+{
+	m_dimensions = dimensions;
+	m_numWordsPerRow = (dimensions.x + 2 + 63) / 64;
+	m_words.assign((dimensions.y + 2) * m_numWordsPerRow, 0);
+
+	if (!borderValue)
+	{
+		return;
+	}
+	for (int tileY = -1; tileY <= dimensions.y; ++tileY)
+	{
+		Set(-1, tileY, true);
+		Set(dimensions.x, tileY, true);
+	}
+	for (int tileX = 0; tileX < dimensions.x; ++tileX)
+	{
+		Set(tileX, -1, true);
+		Set(tileX, dimensions.y, true);
+	}
+}
+
+void TileBitGrid::Set(int tileX, int tileY, bool value)
+{
+	int bitIndex = GetBitIndexInRow(tileX);
+	uint64_t& word = m_words[(tileY + 1) * m_numWordsPerRow + (bitIndex >> 6)];
+	uint64_t bit = 1ull << (bitIndex & 63);
+	word = value ? (word | bit) : (word & ~bit);
+}
+
+bool TileBitGrid::IsSetSafe(int tileX, int tileY, bool outsideValue) const
+{
+	if ((unsigned int)(tileX + 1) >= (unsigned int)(m_dimensions.x + 2) || (unsigned int)(tileY + 1) >= (unsigned int)(m_dimensions.y + 2))
+	{
+		return outsideValue;
+	}
+	return IsSet(tileX, tileY);
+}
+
+//-----------------------------------------------------------------------------------------------
+uint64_t const* TileBitGrid::GetRowWords(int tileY) const
+{
+	return &m_words[(tileY + 1) * m_numWordsPerRow];
+}
+
+int TileBitGrid::CountSetTilesInRow(int tileY) const
+{
+	uint64_t const* rowWords = GetRowWords(tileY);
+	int numSet = 0;
+	for (int wordIndex = 0; wordIndex < m_numWordsPerRow; ++wordIndex)
+	{
+		numSet += CountSetBits(rowWords[wordIndex] & GetInteriorMask(wordIndex));
+	}
+	return numSet;
+}
+
+int TileBitGrid::CountSetTiles() const
+{
+	int numSet = 0;
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		numSet += CountSetTilesInRow(tileY);
+	}
+	return numSet;
+}
+
+bool TileBitGrid::IsAnySetInRow(int tileY, int minTileX, int maxTileX) const
+{
+	int firstBit = GetBitIndexInRow((minTileX < -1) ? -1 : minTileX);
+	int lastBit = GetBitIndexInRow((maxTileX > m_dimensions.x) ? m_dimensions.x : maxTileX);
+	if (firstBit > lastBit)
+	{
+		return false;
+	}
+
+	uint64_t const* rowWords = GetRowWords(tileY);
+	int firstWord = firstBit >> 6;
+	int lastWord = lastBit >> 6;
+	for (int wordIndex = firstWord; wordIndex <= lastWord; ++wordIndex)
+	{
+		uint64_t mask = ~0ull;
+		if (wordIndex == firstWord)
+		{
+			mask &= ~0ull << (firstBit & 63);
+		}
+		if (wordIndex == lastWord)
+		{
+			mask &= ~0ull >> (63 - (lastBit & 63));
+		}
+		if ((rowWords[wordIndex] & mask) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t TileBitGrid::GetInteriorMask(int wordIndex) const
+{
+	// Interior bits are [1, dimensions.x] of the padded row
+	int firstBit = 1;
+	int lastBit = m_dimensions.x;
+	int wordFirstBit = wordIndex << 6;
+	int wordLastBit = wordFirstBit + 63;
+	if (lastBit < wordFirstBit || firstBit > wordLastBit)
+	{
+		return 0;
+	}
+	uint64_t mask = ~0ull;
+	if (firstBit > wordFirstBit)
+	{
+		mask &= ~0ull << (firstBit - wordFirstBit);
+	}
+	if (lastBit < wordLastBit)
+	{
+		mask &= ~0ull >> (wordLastBit - lastBit);
+	}
+	return mask;
+}
+
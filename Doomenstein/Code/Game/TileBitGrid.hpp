@@ -0,0 +1,71 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <stdint.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+int CountTrailingZeroBits(uint64_t word); // word must not be 0
+int CountSetBits(uint64_t word);
+
+//-----------------------------------------------------------------------------------------------
+// One bit per tile, packed into 64-bit words per row. The grid is padded with a one tile border
+// on every side (coords -1 and dimensions.x / dimensions.y), so any neighbour of an in-bounds tile
+// can be read without a bounds check. Bit 0 of a row is column -1.
+//
+class TileBitGrid
+{
+public:
+	void Initialize(IntVec2 const& dimensions, bool borderValue);
+
+	// Valid for -1 <= x <= dimensions.x and -1 <= y <= dimensions.y, no checks
+	bool IsSet(int tileX, int tileY) const;
+	void Set(int tileX, int tileY, bool value);
+
+	// Any coords, everything outside of the padded grid reads as outsideValue
+	bool IsSetSafe(int tileX, int tileY, bool outsideValue) const;
+
+	// Row helpers, word at a time
+	uint64_t const* GetRowWords(int tileY) const; // padded row, tileY in [-1, dimensions.y]
+	int GetNumWordsPerRow() const { return m_numWordsPerRow; }
+	IntVec2 GetDimensions() const { return m_dimensions; }
+	int CountSetTilesInRow(int tileY) const; // inside the map only, the border is not counted
+	int CountSetTiles() const;
+	bool IsAnySetInRow(int tileY, int minTileX, int maxTileX) const; // inclusive range, clamped to the padded row
+
+	// Calls callback(tileX) for every tile in [0, dimensions.x) of the row whose bit is clear
+	template <typename CALLBACK_TYPE>
+	void ForEachClearTileInRow(int tileY, CALLBACK_TYPE const& callback) const;
+
+private:
+	int GetBitIndexInRow(int tileX) const { return tileX + 1; }
+	uint64_t GetInteriorMask(int wordIndex) const; // bits of the word that are inside the map
+
+private:
+	IntVec2					m_dimensions;
+	int						m_numWordsPerRow = 0;
+	std::vector<uint64_t>	m_words; // (dimensions.y + 2) rows of m_numWordsPerRow words
+};
+
+//-----------------------------------------------------------------------------------------------
+inline bool TileBitGrid::IsSet(int tileX, int tileY) const
+{
+	int bitIndex = GetBitIndexInRow(tileX);
+	return ((m_words[(tileY + 1) * m_numWordsPerRow + (bitIndex >> 6)] >> (bitIndex & 63)) & 1) != 0;
+}
+
+template <typename CALLBACK_TYPE>
+void TileBitGrid::ForEachClearTileInRow(int tileY, CALLBACK_TYPE const& callback) const
+{
+	uint64_t const* rowWords = GetRowWords(tileY);
+	for (int wordIndex = 0; wordIndex < m_numWordsPerRow; ++wordIndex)
+	{
+		uint64_t clearBits = ~rowWords[wordIndex] & GetInteriorMask(wordIndex);
+		while (clearBits != 0)
+		{
+			int bitIndex = (wordIndex << 6) + CountTrailingZeroBits(clearBits);
+			callback(bitIndex - 1);
+			clearBits &= clearBits - 1;
+		}
+	}
+}
+
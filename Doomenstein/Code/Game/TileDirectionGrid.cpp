@@ -0,0 +1,56 @@
+#include "Game/TileDirectionGrid.hpp"
+#include "Game/FlowFieldBuilder.hpp"
+#include "Engine/Core/HeatMaps.hpp"
+
+//-----------------------------------------------------------------------------------------------
+TileDirectionGrid::TileDirectionGrid(IntVec2 const& dimensions)
+	: m_dimensions(dimensions)
+	, m_bytesPerRow((dimensions.x + 1) / 2)
+	, m_packedCodes(((dimensions.x + 1) / 2) * dimensions.y, 0)
+{
+}
+
+void TileDirectionGrid::SetCode(int tileX, int tileY, unsigned char directionCode)
+{
+	unsigned char& packedCodes = m_packedCodes[tileY * m_bytesPerRow + (tileX >> 1)];
+	if (tileX & 1)
+	{
+		packedCodes = (unsigned char)((packedCodes & 0x0F) | (directionCode << 4));
+	}
+	else
+	{
+		packedCodes = (unsigned char)((packedCodes & 0xF0) | directionCode);
+	}
+}
+
+void TileDirectionGrid::SetRowCodes(int tileY, unsigned char const* directionCodes)
+{
+	unsigned char* packedRow = &m_packedCodes[tileY * m_bytesPerRow];
+	for (int byteIndex = 0; byteIndex < m_bytesPerRow; ++byteIndex)
+	{
+		int tileX = byteIndex * 2;
+		unsigned char highCode = (tileX + 1 < m_dimensions.x) ? directionCodes[tileX + 1] : 0;
+		packedRow[byteIndex] = (unsigned char)(directionCodes[tileX] | (highCode << 4));
+	}
+}
+
+Vec2 TileDirectionGrid::GetDirection(IntVec2 const& tileCoords) const
+{
+	return FlowFieldBuilder::GetDirectionVector(GetCode(tileCoords.x, tileCoords.y));
+}
+
+bool TileDirectionGrid::IsInBounds(IntVec2 const& tileCoords) const
+{
+	return tileCoords.x >= 0 && tileCoords.y >= 0 && tileCoords.x < m_dimensions.x && tileCoords.y < m_dimensions.y;
+}
+
+void TileDirectionGrid::CopyToVectorField(TileVectorField& out_flowField) const
+{
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			out_flowField.SetValueAtIndex(tileX + tileY * m_dimensions.x, GetDirection(IntVec2(tileX, tileY)));
+		}
+	}
+}
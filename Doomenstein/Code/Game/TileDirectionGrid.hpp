@@ -0,0 +1,40 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+
+class TileVectorField;
+
+//-----------------------------------------------------------------------------------------------
+// Flow field as FlowFieldBuilder direction codes (0 = stay, i + 1 = direction i), 4 bits per tile,
+// instead of a Vec2 per tile. Every row starts on a new byte, so bands of rows can be written from
+// different threads. GetDirection decodes a code to its unit vector.
+//
+class TileDirectionGrid
+{
+public:
+	TileDirectionGrid() = default;
+	explicit TileDirectionGrid(IntVec2 const& dimensions); // every tile stays
+
+	unsigned char GetCode(int tileX, int tileY) const;
+	void SetCode(int tileX, int tileY, unsigned char directionCode);
+	void SetRowCodes(int tileY, unsigned char const* directionCodes); // one byte per tile, dimensions.x of them
+	Vec2 GetDirection(IntVec2 const& tileCoords) const;
+	bool IsInBounds(IntVec2 const& tileCoords) const;
+
+	IntVec2 GetDimensions() const { return m_dimensions; }
+	int GetMemoryBytes() const { return (int)m_packedCodes.size(); }
+	void CopyToVectorField(TileVectorField& out_flowField) const; // decoded, for debug draw
+
+private:
+	IntVec2						m_dimensions;
+	int							m_bytesPerRow = 0;
+	std::vector<unsigned char>	m_packedCodes; // even tileX in the low nibble
+};
+
+//-----------------------------------------------------------------------------------------------
+inline unsigned char TileDirectionGrid::GetCode(int tileX, int tileY) const
+{
+	unsigned char packedCodes = m_packedCodes[tileY * m_bytesPerRow + (tileX >> 1)];
+	return (tileX & 1) ? (unsigned char)(packedCodes >> 4) : (unsigned char)(packedCodes & 0x0F);
+}
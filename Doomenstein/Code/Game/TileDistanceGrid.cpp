@@ -0,0 +1,47 @@
+#include "Game/TileDistanceGrid.hpp"
+#include "Engine/Core/HeatMaps.hpp"
+#include <algorithm>
+#include <math.h>
+
+//-----------------------------------------------------------------------------------------------
+TileDistanceGrid::TileDistanceGrid(IntVec2 const& dimensions, float value)
+	: m_dimensions(dimensions)
+	, m_codes(dimensions.x * dimensions.y, EncodeValue(value))
+{
+}
+
+uint16_t TileDistanceGrid::EncodeValue(float value)
+{
+	float roundedValue = floorf(value + 0.5f);
+	if (roundedValue > static_cast<float>(TILE_DISTANCE_MAX_CODE - TILE_DISTANCE_BIAS))
+	{
+		return TILE_DISTANCE_INFINITE_CODE;
+	}
+	if (roundedValue < static_cast<float>(-TILE_DISTANCE_BIAS))
+	{
+		return 0;
+	}
+	return (uint16_t)(static_cast<int>(roundedValue) + TILE_DISTANCE_BIAS);
+}
+
+float TileDistanceGrid::DecodeValue(uint16_t code)
+{
+	if (code == TILE_DISTANCE_INFINITE_CODE)
+	{
+		return TILE_DISTANCE_INFINITE;
+	}
+	return static_cast<float>((int)code - TILE_DISTANCE_BIAS);
+}
+
+void TileDistanceGrid::SetAllValues(float value)
+{
+	std::fill(m_codes.begin(), m_codes.end(), EncodeValue(value));
+}
+
+void TileDistanceGrid::CopyToHeatMap(TileHeatMap& out_heatMap) const
+{
+	for (int tileIndex = 0; tileIndex < GetNumTiles(); ++tileIndex)
+	{
+		out_heatMap.SetValueAtIndex(tileIndex, DecodeValue(m_codes[tileIndex]));
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <stdint.h>
+#include <vector>
+
+class TileHeatMap;
+
+//-----------------------------------------------------------------------------------------------
+constexpr int TILE_DISTANCE_BIAS = 32768;				// code = value + bias
+constexpr uint16_t TILE_DISTANCE_MAX_CODE = 0xFFFE;		// largest finite code, value 32766
+constexpr uint16_t TILE_DISTANCE_INFINITE_CODE = 0xFFFF;
+constexpr float TILE_DISTANCE_INFINITE = 999999.f;		// what the infinite code decodes to, and encodes from
+
+//-----------------------------------------------------------------------------------------------
+// Nav distance map with a 16-bit code per tile instead of a float. Nav distances are whole tile
+// steps, so code = value + TILE_DISTANCE_BIAS holds every value in [-32768, 32766] exactly and
+// keeps their order; anything larger saturates to the infinite code. Because the code is monotonic,
+// spreads and flow descent can compare codes directly and only queries decode to float.
+//
+class TileDistanceGrid
+{
+public:
+	TileDistanceGrid() = default;
+	explicit TileDistanceGrid(IntVec2 const& dimensions, float value = 0.f);
+
+	static uint16_t EncodeValue(float value); // rounds to the nearest whole value, saturates
+	static float DecodeValue(uint16_t code);
+
+	float GetValueAtIndex(int tileIndex) const { return DecodeValue(m_codes[tileIndex]); }
+	void SetValueAtIndex(int tileIndex, float value) { m_codes[tileIndex] = EncodeValue(value); }
+	void SetValueAtCoords(IntVec2 const& tileCoords, float value) { SetValueAtIndex(tileCoords.x + tileCoords.y * m_dimensions.x, value); }
+	void SetAllValues(float value);
+	uint16_t GetCodeAtIndex(int tileIndex) const { return m_codes[tileIndex]; }
+	void SetCodeAtIndex(int tileIndex, uint16_t code) { m_codes[tileIndex] = code; }
+	uint16_t const* GetCodes() const { return m_codes.data(); }
+
+	IntVec2 GetDimensions() const { return m_dimensions; }
+	int GetNumTiles() const { return (int)m_codes.size(); }
+	int GetMemoryBytes() const { return (int)(m_codes.size() * sizeof(uint16_t)); }
+	void CopyToHeatMap(TileHeatMap& out_heatMap) const; // decoded, for debug draw
+
+private:
+	IntVec2					m_dimensions;
+	std::vector<uint16_t>	m_codes;
+};
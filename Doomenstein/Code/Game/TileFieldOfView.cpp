@@ -0,0 +1,140 @@
+#include "Game/TileFieldOfView.hpp"
+#include "Game/TileBitGrid.hpp"
+
+//-----------------------------------------------------------------------------------------------
+namespace
+{
+	struct Slope
+	{
+		int m_numerator = 0;
+		int m_denominator = 1; // always positive
+	};
+
+	enum class Quadrant
+	{
+		NORTH,
+		SOUTH,
+		EAST,
+		WEST,
+	};
+
+	struct Shadowcaster
+	{
+		TileBitGrid const* m_blockingTiles = nullptr;
+		IntVec2 m_originTile;
+		float m_rangeSquared = 0.f;
+		int m_maxDepth = 0;
+		Quadrant m_quadrant = Quadrant::NORTH;
+		std::vector<IntVec2>* m_visibleTiles = nullptr;
+
+		IntVec2 GetTileCoords(int depth, int column) const;
+		void RevealTile(IntVec2 const& tileCoords) const;
+		void ScanRow(int depth, Slope startSlope, Slope endSlope) const;
+	};
+
+	int FloorDivide(int numerator, int denominator) // denominator > 0
+	{
+		return (numerator >= 0) ? (numerator / denominator) : -((-numerator + denominator - 1) / denominator);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+IntVec2 Shadowcaster::GetTileCoords(int depth, int column) const
+{
+	switch (m_quadrant)
+	{
+	case Quadrant::NORTH:	return IntVec2(m_originTile.x + column, m_originTile.y + depth);
+	case Quadrant::SOUTH:	return IntVec2(m_originTile.x + column, m_originTile.y - depth);
+	case Quadrant::EAST:	return IntVec2(m_originTile.x + depth, m_originTile.y + column);
+	default:				return IntVec2(m_originTile.x - depth, m_originTile.y + column);
+	}
+}
+
+void Shadowcaster::RevealTile(IntVec2 const& tileCoords) const
+{
+	IntVec2 dimensions = m_blockingTiles->GetDimensions();
+	if (tileCoords.x < 0 || tileCoords.y < 0 || tileCoords.x >= dimensions.x || tileCoords.y >= dimensions.y)
+	{
+		return;
+	}
+	float deltaX = static_cast<float>(tileCoords.x - m_originTile.x);
+	float deltaY = static_cast<float>(tileCoords.y - m_originTile.y);
+	if (deltaX * deltaX + deltaY * deltaY > m_rangeSquared)
+	{
+		return;
+	}
+	m_visibleTiles->push_back(tileCoords);
+}
+
+void Shadowcaster::ScanRow(int depth, Slope startSlope, Slope endSlope) const
+{
+	if (depth > m_maxDepth)
+	{
+		return;
+	}
+
+	// Columns whose center is within the slopes, rounding ties towards the inside of the row
+	int minColumn = FloorDivide(2 * depth * startSlope.m_numerator + startSlope.m_denominator, 2 * startSlope.m_denominator);
+	int maxColumn = -FloorDivide(endSlope.m_denominator - 2 * depth * endSlope.m_numerator, 2 * endSlope.m_denominator);
+
+	bool hasPreviousTile = false;
+	bool wasPreviousTileBlocking = false;
+	for (int column = minColumn; column <= maxColumn; ++column)
+	{
+		IntVec2 tileCoords = GetTileCoords(depth, column);
+		bool isBlocking = m_blockingTiles->IsSetSafe(tileCoords.x, tileCoords.y, true);
+		bool isSymmetric = column * startSlope.m_denominator >= depth * startSlope.m_numerator
+			&& column * endSlope.m_denominator <= depth * endSlope.m_numerator;
+		if (isBlocking || isSymmetric)
+		{
+			RevealTile(tileCoords);
+		}
+
+		Slope tileStartSlope = { 2 * column - 1, 2 * depth };
+		if (hasPreviousTile && wasPreviousTileBlocking && !isBlocking)
+		{
+			startSlope = tileStartSlope;
+		}
+		if (hasPreviousTile && !wasPreviousTileBlocking && isBlocking)
+		{
+			ScanRow(depth + 1, startSlope, tileStartSlope);
+		}
+		hasPreviousTile = true;
+		wasPreviousTileBlocking = isBlocking;
+	}
+
+	if (hasPreviousTile && !wasPreviousTileBlocking)
+	{
+		ScanRow(depth + 1, startSlope, endSlope);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+static Shadowcaster MakeShadowcaster(TileBitGrid const& blockingTiles, IntVec2 const& originTile, float range, std::vector<IntVec2>& out_visibleTiles)
+{
+	Shadowcaster shadowcaster;
+	shadowcaster.m_blockingTiles = &blockingTiles;
+	shadowcaster.m_originTile = originTile;
+	shadowcaster.m_rangeSquared = range * range;
+	shadowcaster.m_maxDepth = static_cast<int>(range); // a tile at depth d is at least d away
+	shadowcaster.m_visibleTiles = &out_visibleTiles;
+	return shadowcaster;
+}
+
+void ComputeTileFieldOfView(TileBitGrid const& blockingTiles, IntVec2 const& originTile, float range, std::vector<IntVec2>& out_visibleTiles)
+{
+	Shadowcaster shadowcaster = MakeShadowcaster(blockingTiles, originTile, range, out_visibleTiles);
+	shadowcaster.RevealTile(originTile);
+	for (int quadrantIndex = 0; quadrantIndex < NUM_FIELD_OF_VIEW_QUADRANTS; ++quadrantIndex)
+	{
+		shadowcaster.m_quadrant = static_cast<Quadrant>(quadrantIndex);
+		shadowcaster.ScanRow(1, Slope{ -1, 1 }, Slope{ 1, 1 });
+	}
+}
+
+void ComputeTileFieldOfViewQuadrant(TileBitGrid const& blockingTiles, IntVec2 const& originTile, float range, int quadrantIndex, std::vector<IntVec2>& out_visibleTiles)
+{
+	Shadowcaster shadowcaster = MakeShadowcaster(blockingTiles, originTile, range, out_visibleTiles);
+	shadowcaster.m_quadrant = static_cast<Quadrant>(quadrantIndex);
+	shadowcaster.ScanRow(1, Slope{ -1, 1 }, Slope{ 1, 1 });
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+class TileBitGrid;
+
+//-----------------------------------------------------------------------------------------------
+// Symmetric recursive shadowcasting over the tile grid, one quadrant at a time with exact integer
+// slopes. A non-blocking tile is visible if its center lies between the open slopes seen from the
+// origin tile center, a blocking tile is visible if any part of it is. Only tiles inside the map
+// whose center is within range of the origin center are appended, so the work is O(visible tiles).
+// Tiles on the quadrant diagonals can be appended twice.
+//
+constexpr int NUM_FIELD_OF_VIEW_QUADRANTS = 4;
+
+void ComputeTileFieldOfView(TileBitGrid const& blockingTiles, IntVec2 const& originTile, float range, std::vector<IntVec2>& out_visibleTiles);
+void ComputeTileFieldOfViewQuadrant(TileBitGrid const& blockingTiles, IntVec2 const& originTile, float range, int quadrantIndex, std::vector<IntVec2>& out_visibleTiles); // origin tile not included
@@ -0,0 +1,204 @@
+#include "Game/TileHeatSpread.hpp"
+#include "Game/TileBitGrid.hpp"
+#include "Game/TileDistanceGrid.hpp"
+
+//-----------------------------------------------------------------------------------------------
+void TileHeatSpread::Begin(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep, TileBitGrid const& blockedTiles)
+{
+	m_distanceMap = &distanceMap;
+	m_blockedTiles = &blockedTiles;
+	m_dimensions = distanceMap.GetDimensions();
+	m_numTiles = distanceMap.GetNumTiles();
+	m_heatSpreadStep = static_cast<int>(heatSpreadStep);
+	m_isHeatIncreasing = m_heatSpreadStep > 0;
+	m_startSearchCode = (int)TileDistanceGrid::EncodeValue(startSearchValue);
+
+	// Sized once per map size, every seeding stage overwrites what it reads
+	if ((int)m_presetLevels.size() != m_numTiles)
+	{
+		m_presetLevels.resize(m_numTiles);
+		m_presetCursors.resize(m_numTiles);
+		m_presetStarts.resize(m_numTiles + 1);
+		m_presetTiles.resize(m_numTiles);
+	}
+
+	m_stage = Stage::CLEAR_COUNTS;
+	m_seedCursor = 0;
+	m_isDone = false;
+}
+
+bool TileHeatSpread::Step(int maxTiles)
+{
+	IntVec2 directions[4] = { IntVec2(0,1), IntVec2(0,-1), IntVec2(1,0), IntVec2(-1,0) };
+
+	int numProcessedTiles = 0;
+	if (!m_isDone && m_stage != Stage::SPREAD)
+	{
+		numProcessedTiles = StepSeeding(maxTiles);
+	}
+	while (!m_isDone && numProcessedTiles < maxTiles)
+	{
+		if (m_levelCursor == (int)m_currentLevelTiles.size())
+		{
+			if (!m_isHeatSpreading)
+			{
+				m_isDone = true;
+				break;
+			}
+			m_currentSearchCode += m_heatSpreadStep;
+			m_level++;
+			BeginLevel();
+			continue;
+		}
+
+		int tileIndex = m_currentLevelTiles[m_levelCursor++];
+		numProcessedTiles++;
+		if ((int)m_distanceMap->GetCodeAtIndex(tileIndex) != m_currentSearchCode)
+		{
+			continue;
+		}
+		m_isHeatSpreading = true;
+
+		int nextSearchCode = m_currentSearchCode + m_heatSpreadStep;
+		IntVec2 const currentTileCoords = IntVec2(tileIndex % m_dimensions.x, tileIndex / m_dimensions.x);
+		for (int i = 0; i < 4; ++i) // four directions
+		{
+			IntVec2 neighborTileCoords = currentTileCoords + directions[i];
+			if (m_blockedTiles->IsSet(neighborTileCoords.x, neighborTileCoords.y)) // border is blocked, no bounds check needed
+			{
+				continue;
+			}
+			int neighborTileIndex = neighborTileCoords.x + neighborTileCoords.y * m_dimensions.x;
+			int neighborTileCode = m_distanceMap->GetCodeAtIndex(neighborTileIndex);
+			if (m_isHeatIncreasing && neighborTileCode <= nextSearchCode)
+			{
+				continue;
+			}
+			if (!m_isHeatIncreasing && neighborTileCode >= nextSearchCode)
+			{
+				continue;
+			}
+			m_distanceMap->SetCodeAtIndex(neighborTileIndex, (uint16_t)nextSearchCode);
+			m_nextLevelTiles.push_back(neighborTileIndex);
+		}
+	}
+	return m_isDone;
+}
+
+//-----------------------------------------------------------------------------------------------
+int TileHeatSpread::StepSeeding(int maxTiles)
+{
+	// Counting sort of the preset tiles into their levels, one tile or level per unit of budget
+	int numProcessed = 0;
+	while (m_stage != Stage::SPREAD && numProcessed < maxTiles)
+	{
+		int endCursor = m_seedCursor + (maxTiles - numProcessed);
+		switch (m_stage)
+		{
+		case Stage::CLEAR_COUNTS:
+		{
+			endCursor = (endCursor < m_numTiles + 1) ? endCursor : m_numTiles + 1;
+			for (int level = m_seedCursor; level < endCursor; ++level)
+			{
+				m_presetStarts[level] = 0;
+			}
+			break;
+		}
+		case Stage::COUNT_PRESETS:
+		{
+			endCursor = (endCursor < m_numTiles) ? endCursor : m_numTiles;
+			for (int tileIndex = m_seedCursor; tileIndex < endCursor; ++tileIndex)
+			{
+				m_presetLevels[tileIndex] = -1;
+				int code = (int)m_distanceMap->GetCodeAtIndex(tileIndex);
+				int codeOffset = code - m_startSearchCode;
+				if (code == TILE_DISTANCE_INFINITE_CODE || codeOffset % m_heatSpreadStep != 0)
+				{
+					continue;
+				}
+				int level = codeOffset / m_heatSpreadStep;
+				if (level >= 0 && level < m_numTiles)
+				{
+					m_presetLevels[tileIndex] = level;
+					m_presetStarts[level + 1]++;
+				}
+			}
+			break;
+		}
+		case Stage::SUM_PRESETS:
+		{
+			endCursor = (endCursor < m_numTiles) ? endCursor : m_numTiles;
+			for (int level = m_seedCursor; level < endCursor; ++level)
+			{
+				m_presetCursors[level] = m_presetStarts[level];
+				m_presetStarts[level + 1] += m_presetStarts[level];
+			}
+			break;
+		}
+		case Stage::PLACE_PRESETS:
+		{
+			endCursor = (endCursor < m_numTiles) ? endCursor : m_numTiles;
+			for (int tileIndex = m_seedCursor; tileIndex < endCursor; ++tileIndex)
+			{
+				if (m_presetLevels[tileIndex] >= 0)
+				{
+					m_presetTiles[m_presetCursors[m_presetLevels[tileIndex]]++] = tileIndex;
+				}
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		numProcessed += endCursor - m_seedCursor;
+		m_seedCursor = endCursor;
+
+		int stageEnd = (m_stage == Stage::CLEAR_COUNTS) ? m_numTiles + 1 : m_numTiles;
+		if (m_seedCursor >= stageEnd)
+		{
+			m_seedCursor = 0;
+			if (m_stage == Stage::CLEAR_COUNTS)
+			{
+				m_stage = Stage::COUNT_PRESETS;
+			}
+			else if (m_stage == Stage::COUNT_PRESETS)
+			{
+				m_stage = Stage::SUM_PRESETS;
+			}
+			else if (m_stage == Stage::SUM_PRESETS)
+			{
+				m_stage = Stage::PLACE_PRESETS;
+			}
+			else
+			{
+				BeginSpread();
+			}
+		}
+	}
+	return numProcessed;
+}
+
+void TileHeatSpread::BeginSpread()
+{
+	m_stage = Stage::SPREAD;
+	m_currentLevelTiles.clear();
+	m_nextLevelTiles.clear();
+	m_level = 0;
+	m_currentSearchCode = m_startSearchCode;
+	BeginLevel();
+}
+
+void TileHeatSpread::BeginLevel()
+{
+	int nextSearchCode = m_currentSearchCode + m_heatSpreadStep;
+	if (m_level >= m_numTiles || nextSearchCode < 0 || nextSearchCode > TILE_DISTANCE_MAX_CODE)
+	{
+		m_isDone = true;
+		return;
+	}
+	std::swap(m_currentLevelTiles, m_nextLevelTiles);
+	m_nextLevelTiles.clear();
+	m_currentLevelTiles.insert(m_currentLevelTiles.end(), m_presetTiles.begin() + m_presetStarts[m_level], m_presetTiles.begin() + m_presetStarts[m_level + 1]);
+	m_levelCursor = 0;
+	m_isHeatSpreading = false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <stdint.h>
+#include <vector>
+
+class TileBitGrid;
+class TileDistanceGrid;
+
+//-----------------------------------------------------------------------------------------------
+// Resumable bucketed (Dial's) heat spread, same result as the old level-by-level rescan:
+// - level k holds tiles whose value is exactly startSearchValue + k * heatSpreadStep when level k is processed
+// - tiles already set to a level's value before the spread are seeded into that level's bucket
+// - processing a level sets each open neighbour that is worse than the next level's value to it, and queues it there
+// - a queued tile is skipped if its value has changed since, and the spread stops at the first level without a valid tile
+// Every tile is processed at most once, so only levels below numTiles can ever be reached.
+// Values and the step are whole numbers and the spread runs on the distance codes; it also stops
+// before a level whose next value would leave the finite code range.
+// Step can be called with a small tile budget to spread the work over several frames; the
+// distance map and blocked tiles must not change in between. Seeding (a counting sort of the preset
+// tiles into their levels) is resumable too, so Begin itself is O(1); its buffers are kept between
+// spreads over maps of the same size.
+//
+class TileHeatSpread
+{
+public:
+	void Begin(TileDistanceGrid& distanceMap, float startSearchValue, float heatSpreadStep, TileBitGrid const& blockedTiles);
+	bool Step(int maxTiles); // processes up to maxTiles queued tiles, true once the spread is done
+	bool IsDone() const { return m_isDone; }
+
+private:
+	enum class Stage
+	{
+		CLEAR_COUNTS,	// zero the level counts
+		COUNT_PRESETS,	// level of every tile, counted per level
+		SUM_PRESETS,	// counts to level starts
+		PLACE_PRESETS,	// tiles into their level's range
+		SPREAD,
+	};
+
+	int StepSeeding(int maxTiles); // returns the budget used
+	void BeginSpread();
+	void BeginLevel();
+
+private:
+	TileDistanceGrid*	m_distanceMap = nullptr;
+	TileBitGrid const*	m_blockedTiles = nullptr;
+	IntVec2				m_dimensions;
+	int					m_numTiles = 0;
+	int					m_heatSpreadStep = 1;
+	bool				m_isHeatIncreasing = true;
+	int					m_startSearchCode = 0;
+	Stage				m_stage = Stage::SPREAD;
+	int					m_seedCursor = 0; // next tile or level of the current seeding stage
+
+	std::vector<int>	m_presetLevels;		// per tile, -1 if not preset
+	std::vector<int>	m_presetCursors;	// per level, next free slot of its range while placing
+	std::vector<int>	m_presetStarts;	// level k's preset tiles are m_presetTiles[m_presetStarts[k], m_presetStarts[k + 1])
+	std::vector<int>	m_presetTiles;
+	std::vector<int>	m_currentLevelTiles;
+	std::vector<int>	m_nextLevelTiles;
+	int					m_level = 0;
+	int					m_levelCursor = 0; // next tile of m_currentLevelTiles to process
+	int					m_currentSearchCode = 0;
+	bool				m_isHeatSpreading = false; // the current level has a valid tile
+	bool				m_isDone = true;
+};
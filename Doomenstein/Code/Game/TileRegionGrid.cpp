@@ -0,0 +1,95 @@
+#include "Game/TileRegionGrid.hpp"
+#include "Game/TileBitGrid.hpp"
+
+//-----------------------------------------------------------------------------------------------
+static int FindRootLabel(std::vector<int>& parentLabels, int label)
+{
+	while (parentLabels[label] != label)
+	{
+		parentLabels[label] = parentLabels[parentLabels[label]]; // path halving
+		label = parentLabels[label];
+	}
+	return label;
+}
+
+static void UnionLabels(std::vector<int>& parentLabels, int labelA, int labelB)
+{
+	int rootA = FindRootLabel(parentLabels, labelA);
+	int rootB = FindRootLabel(parentLabels, labelB);
+	if (rootA < rootB)
+	{
+		parentLabels[rootB] = rootA;
+	}
+	else if (rootB < rootA)
+	{
+		parentLabels[rootA] = rootB;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+void TileRegionGrid::Build(TileBitGrid const& blockedTiles)
+{
+	m_dimensions = blockedTiles.GetDimensions();
+	int numTiles = m_dimensions.x * m_dimensions.y;
+	m_regionIds.assign(numTiles, NO_REGION);
+	m_regionSizes.clear();
+
+	// First pass: one provisional label per run of open tiles in a row, joined with every label the run touches in the row below
+	std::vector<int> parentLabels;
+	for (int tileY = 0; tileY < m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < m_dimensions.x; ++tileX)
+		{
+			if (blockedTiles.IsSet(tileX, tileY))
+			{
+				continue;
+			}
+			int tileIndex = tileX + tileY * m_dimensions.x;
+			int label = (tileX > 0) ? m_regionIds[tileIndex - 1] : NO_REGION;
+			if (label == NO_REGION)
+			{
+				label = (int)parentLabels.size();
+				parentLabels.push_back(label);
+			}
+			m_regionIds[tileIndex] = label;
+
+			if (tileY > 0 && m_regionIds[tileIndex - m_dimensions.x] != NO_REGION)
+			{
+				UnionLabels(parentLabels, label, m_regionIds[tileIndex - m_dimensions.x]);
+			}
+		}
+	}
+
+	// Second pass: every label to its root, roots numbered in the order they are first seen
+	std::vector<int> rootRegionIds(parentLabels.size(), NO_REGION);
+	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+	{
+		if (m_regionIds[tileIndex] == NO_REGION)
+		{
+			continue;
+		}
+		int rootLabel = FindRootLabel(parentLabels, m_regionIds[tileIndex]);
+		if (rootRegionIds[rootLabel] == NO_REGION)
+		{
+			rootRegionIds[rootLabel] = (int)m_regionSizes.size();
+			m_regionSizes.push_back(0);
+		}
+		m_regionIds[tileIndex] = rootRegionIds[rootLabel];
+		m_regionSizes[m_regionIds[tileIndex]]++;
+	}
+}
+
+int TileRegionGrid::GetRegion(int tileX, int tileY) const
+{
+	if (tileX < 0 || tileY < 0 || tileX >= m_dimensions.x || tileY >= m_dimensions.y)
+	{
+		return NO_REGION;
+	}
+	return m_regionIds[tileX + tileY * m_dimensions.x];
+}
+
+bool TileRegionGrid::AreTilesConnected(IntVec2 const& tileA, IntVec2 const& tileB) const
+{
+	int regionA = GetRegion(tileA);
+	return regionA != NO_REGION && regionA == GetRegion(tileB);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <vector>
+
+class TileBitGrid;
+
+//-----------------------------------------------------------------------------------------------
+constexpr int NO_REGION = -1;
+
+//-----------------------------------------------------------------------------------------------
+// Labels every 4-connected region of open tiles in one scanline pass with union-find, then
+// resolves the labels to compact region ids in scan order. Two tiles are connected exactly when
+// they have the same region id, so reachability checks are a lookup.
+//
+class TileRegionGrid
+{
+public:
+	void Build(TileBitGrid const& blockedTiles);
+
+	int GetRegion(int tileX, int tileY) const; // NO_REGION for blocked tiles and outside the map
+	int GetRegion(IntVec2 const& tileCoords) const { return GetRegion(tileCoords.x, tileCoords.y); }
+	bool AreTilesConnected(IntVec2 const& tileA, IntVec2 const& tileB) const;
+	int GetNumRegions() const { return (int)m_regionSizes.size(); }
+	int GetRegionSize(int regionId) const { return m_regionSizes[regionId]; } // number of tiles
+
+private:
+	IntVec2				m_dimensions;
+	std::vector<int>	m_regionIds;
+	std::vector<int>	m_regionSizes;
+};
@@ -0,0 +1,86 @@
+#include "Game/TileVisibilitySet.hpp"
+#include "Game/TileBitGrid.hpp"
+
+//-----------------------------------------------------------------------------------------------
+void TileVisibilitySet::Initialize(IntVec2 const& dimensions, int radius, TileBitGrid const& blockingTiles)
+{
+	Clear();
+	if (radius <= 0)
+	{
+		return;
+	}
+
+	m_dimensions = dimensions;
+	m_radius = radius;
+	m_windowSize = 2 * radius + 1;
+	m_numWordsPerTile = (m_windowSize * m_windowSize + 63) / 64;
+
+	m_sourceIndexes.assign(dimensions.x * dimensions.y, -1);
+	for (int tileY = 0; tileY < dimensions.y; ++tileY)
+	{
+		blockingTiles.ForEachClearTileInRow(tileY, [&](int tileX)
+			{
+				m_sourceIndexes[tileX + tileY * dimensions.x] = m_numSourceTiles++;
+			});
+	}
+	m_words.assign((size_t)m_numSourceTiles * m_numWordsPerTile, 0);
+}
+
+void TileVisibilitySet::Clear()
+{
+	m_radius = 0;
+	m_windowSize = 0;
+	m_numWordsPerTile = 0;
+	m_numSourceTiles = 0;
+	m_sourceIndexes.clear();
+	m_words.clear();
+}
+
+//-----------------------------------------------------------------------------------------------
+bool TileVisibilitySet::HasEntry(IntVec2 const& fromTile, IntVec2 const& toTile) const
+{
+	if (m_radius <= 0)
+	{
+		return false;
+	}
+	if (fromTile.x < 0 || fromTile.y < 0 || fromTile.x >= m_dimensions.x || fromTile.y >= m_dimensions.y)
+	{
+		return false;
+	}
+	if (m_sourceIndexes[fromTile.x + fromTile.y * m_dimensions.x] < 0)
+	{
+		return false;
+	}
+	int deltaX = toTile.x - fromTile.x;
+	int deltaY = toTile.y - fromTile.y;
+	return deltaX >= -m_radius && deltaX <= m_radius && deltaY >= -m_radius && deltaY <= m_radius;
+}
+
+bool TileVisibilitySet::IsVisible(IntVec2 const& fromTile, IntVec2 const& toTile) const
+{
+	size_t bitIndex = GetBitIndex(fromTile, toTile);
+	return ((m_words[bitIndex >> 6] >> (bitIndex & 63)) & 1) != 0;
+}
+
+void TileVisibilitySet::SetVisible(IntVec2 const& fromTile, IntVec2 const& toTile, bool isVisible)
+{
+	size_t bitIndex = GetBitIndex(fromTile, toTile);
+	uint64_t bit = 1ull << (bitIndex & 63);
+	uint64_t& word = m_words[bitIndex >> 6];
+	word = isVisible ? (word | bit) : (word & ~bit);
+}
+
+size_t TileVisibilitySet::GetMemoryBytes() const
+{
+	return m_words.size() * sizeof(uint64_t) + m_sourceIndexes.size() * sizeof(int);
+}
+
+//-----------------------------------------------------------------------------------------------
+size_t TileVisibilitySet::GetBitIndex(IntVec2 const& fromTile, IntVec2 const& toTile) const
+{
+	int sourceIndex = m_sourceIndexes[fromTile.x + fromTile.y * m_dimensions.x];
+	int windowX = toTile.x - fromTile.x + m_radius;
+	int windowY = toTile.y - fromTile.y + m_radius;
+	// Large maps with a large radius overflow an int here
+	return (size_t)sourceIndex * m_numWordsPerTile * 64 + windowX + windowY * m_windowSize;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Engine/Math/IntVec2.hpp"
+#include <stdint.h>
+#include <vector>
+
+class TileBitGrid;
+
+//-----------------------------------------------------------------------------------------------
+// Potentially visible set between tile centers, baked once per map. Every non-blocking tile owns a
+// bitset over the (2 * radius + 1)^2 window of tiles around it, blocking tiles own nothing, so the
+// memory scales with the open area and the radius instead of the square of the map size.
+// Bits can be filled from several threads as long as each thread owns different source tiles.
+//
+class TileVisibilitySet
+{
+public:
+	void Initialize(IntVec2 const& dimensions, int radius, TileBitGrid const& blockingTiles);
+	void Clear();
+
+	bool IsBuilt() const { return m_radius > 0; }
+	bool HasEntry(IntVec2 const& fromTile, IntVec2 const& toTile) const; // fromTile is open and toTile is inside its window
+	bool IsVisible(IntVec2 const& fromTile, IntVec2 const& toTile) const; // HasEntry must be true
+	void SetVisible(IntVec2 const& fromTile, IntVec2 const& toTile, bool isVisible); // HasEntry must be true
+
+	int GetRadius() const { return m_radius; }
+	int GetNumSourceTiles() const { return m_numSourceTiles; }
+	size_t GetMemoryBytes() const;
+
+private:
+	size_t GetBitIndex(IntVec2 const& fromTile, IntVec2 const& toTile) const;
+
+private:
+	IntVec2 m_dimensions;
+	int m_radius = 0;
+	int m_windowSize = 0; // 2 * radius + 1
+	int m_numWordsPerTile = 0;
+	int m_numSourceTiles = 0;
+	std::vector<int> m_sourceIndexes; // per map tile, -1 for blocking tiles
+	std::vector<uint64_t> m_words; // m_numWordsPerTile words per source tile
+};
@@ -0,0 +1,186 @@
+#include "Game/VoxelRayBatch.hpp"
+#include "Game/TileBitGrid.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include <emmintrin.h>
+#include <math.h>
+
+//-----------------------------------------------------------------------------------------------
+static constexpr float RAY_NO_CLIP = 3.402823466e+38f; // FLT_MAX
+
+//-----------------------------------------------------------------------------------------------
+void VoxelRayBatch::Clear()
+{
+	m_startsX.clear();
+	m_startsY.clear();
+	m_forwardsX.clear();
+	m_forwardsY.clear();
+	m_lengths.clear();
+	m_minHitDists.clear();
+	m_maxHitDists.clear();
+	m_hits.clear();
+}
+
+int VoxelRayBatch::AddRay(Vec2 const& start, Vec2 const& forward, float length)
+{
+	return AddClippedRay(start, forward, length, -RAY_NO_CLIP, RAY_NO_CLIP);
+}
+
+int VoxelRayBatch::AddClippedRay(Vec2 const& start, Vec2 const& forward, float length, float minHitDist, float maxHitDist)
+{
+	m_startsX.push_back(start.x);
+	m_startsY.push_back(start.y);
+	m_forwardsX.push_back(forward.x);
+	m_forwardsY.push_back(forward.y);
+	m_lengths.push_back(length);
+	m_minHitDists.push_back(minHitDist);
+	m_maxHitDists.push_back(maxHitDist);
+	m_hits.emplace_back();
+	return (int)m_hits.size() - 1;
+}
+
+void VoxelRayBatch::Trace(TileBitGrid const& solidTiles)
+{
+	// Same step direction rule as the scalar walk: negative is -1, zero and positive are +1
+	for (std::vector<int>& quadrantRays : m_quadrantRays)
+	{
+		quadrantRays.clear();
+	}
+	for (int rayIndex = 0; rayIndex < GetNumRays(); ++rayIndex)
+	{
+		int quadrantIndex = (m_forwardsY[rayIndex] < 0.f) ? ((m_forwardsX[rayIndex] < 0.f) ? 2 : 3) : ((m_forwardsX[rayIndex] < 0.f) ? 1 : 0);
+		m_quadrantRays[quadrantIndex].push_back(rayIndex);
+	}
+
+	for (int first = 0; first < (int)m_quadrantRays[0].size(); first += 4)
+	{
+		TracePacket<1, 1>(solidTiles, &m_quadrantRays[0][first], (int)m_quadrantRays[0].size() - first);
+	}
+	for (int first = 0; first < (int)m_quadrantRays[1].size(); first += 4)
+	{
+		TracePacket<-1, 1>(solidTiles, &m_quadrantRays[1][first], (int)m_quadrantRays[1].size() - first);
+	}
+	for (int first = 0; first < (int)m_quadrantRays[2].size(); first += 4)
+	{
+		TracePacket<-1, -1>(solidTiles, &m_quadrantRays[2][first], (int)m_quadrantRays[2].size() - first);
+	}
+	for (int first = 0; first < (int)m_quadrantRays[3].size(); first += 4)
+	{
+		TracePacket<1, -1>(solidTiles, &m_quadrantRays[3][first], (int)m_quadrantRays[3].size() - first);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+template <int STEP_X, int STEP_Y>
+void VoxelRayBatch::TracePacket(TileBitGrid const& solidTiles, int const* rayIndices, int numRays)
+{
+	int numLanes = (numRays < 4) ? numRays : 4;
+
+	// Unused lanes have a negative length, so they are done before their first crossing
+	float startsX[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+	float startsY[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+	float forwardsX[4] = { 1.f, 1.f, 1.f, 1.f };
+	float forwardsY[4] = { 1.f, 1.f, 1.f, 1.f };
+	float lengths[4] = { -1.f, -1.f, -1.f, -1.f };
+	float minHitDists[4] = { 0.f, 0.f, 0.f, 0.f };
+	float maxHitDists[4] = { 0.f, 0.f, 0.f, 0.f };
+	int tileXs[4] = { 0, 0, 0, 0 };
+	int tileYs[4] = { 0, 0, 0, 0 };
+	int activeMask = 0;
+	for (int lane = 0; lane < numLanes; ++lane)
+	{
+		int rayIndex = rayIndices[lane];
+		startsX[lane] = m_startsX[rayIndex];
+		startsY[lane] = m_startsY[rayIndex];
+		forwardsX[lane] = m_forwardsX[rayIndex];
+		forwardsY[lane] = m_forwardsY[rayIndex];
+		lengths[lane] = m_lengths[rayIndex];
+		minHitDists[lane] = m_minHitDists[rayIndex];
+		maxHitDists[lane] = m_maxHitDists[rayIndex];
+		tileXs[lane] = RoundDownToInt(startsX[lane]);
+		tileYs[lane] = RoundDownToInt(startsY[lane]);
+
+		VoxelRayHit& hit = m_hits[rayIndex];
+		hit = VoxelRayHit();
+		hit.m_impactDist = lengths[lane];
+		if (solidTiles.IsSetSafe(tileXs[lane], tileYs[lane], true) && minHitDists[lane] <= 0.f && maxHitDists[lane] >= 0.f)
+		{
+			hit.m_didImpact = true;
+			hit.m_isStartInside = true;
+			hit.m_impactDist = 0.f;
+			continue;
+		}
+		activeMask |= 1 << lane;
+	}
+
+	// First crossings, same math as the scalar walk
+	__m128 const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 const one = _mm_set1_ps(1.f);
+	__m128i tilesX = _mm_loadu_si128((__m128i const*)tileXs);
+	__m128i tilesY = _mm_loadu_si128((__m128i const*)tileYs);
+	__m128 fwdDistsPerXCrossing = _mm_div_ps(one, _mm_and_ps(_mm_loadu_ps(forwardsX), absMask));
+	__m128 fwdDistsPerYCrossing = _mm_div_ps(one, _mm_and_ps(_mm_loadu_ps(forwardsY), absMask));
+	__m128 xsAtFirstXCrossing = _mm_add_ps(_mm_cvtepi32_ps(tilesX), _mm_set1_ps(static_cast<float>(STEP_X + 1) * 0.5f));
+	__m128 ysAtFirstYCrossing = _mm_add_ps(_mm_cvtepi32_ps(tilesY), _mm_set1_ps(static_cast<float>(STEP_Y + 1) * 0.5f));
+	__m128 fwdDistsAtNextXCrossing = _mm_mul_ps(_mm_and_ps(_mm_sub_ps(xsAtFirstXCrossing, _mm_loadu_ps(startsX)), absMask), fwdDistsPerXCrossing);
+	__m128 fwdDistsAtNextYCrossing = _mm_mul_ps(_mm_and_ps(_mm_sub_ps(ysAtFirstYCrossing, _mm_loadu_ps(startsY)), absMask), fwdDistsPerYCrossing);
+	__m128 rayLengths = _mm_loadu_ps(lengths);
+	__m128 minHits = _mm_loadu_ps(minHitDists);
+	__m128 maxHits = _mm_loadu_ps(maxHitDists);
+	Vec2 const normalAfterXCrossing = Vec2(-static_cast<float>(STEP_X), 0.f);
+	Vec2 const normalAfterYCrossing = Vec2(0.f, -static_cast<float>(STEP_Y));
+
+	while (activeMask != 0)
+	{
+		// Every lane crosses its nearer axis; past the length or the clip the ray is done with no impact
+		__m128 isXCrossing = _mm_cmple_ps(fwdDistsAtNextXCrossing, fwdDistsAtNextYCrossing);
+		__m128 fwdDists = _mm_or_ps(_mm_and_ps(isXCrossing, fwdDistsAtNextXCrossing), _mm_andnot_ps(isXCrossing, fwdDistsAtNextYCrossing));
+		__m128 isPastEnd = _mm_or_ps(_mm_cmpgt_ps(fwdDists, rayLengths), _mm_cmpgt_ps(fwdDists, maxHits));
+		activeMask &= ~_mm_movemask_ps(isPastEnd);
+		__m128 isActive = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(_mm_set1_epi32(activeMask), _mm_setr_epi32(1, 2, 4, 8)), _mm_setzero_si128()));
+		__m128 isStepX = _mm_and_ps(isXCrossing, isActive);
+		__m128 isStepY = _mm_andnot_ps(isXCrossing, isActive);
+
+		// Masks are all ones (-1), so subtracting one steps +1 and adding it steps -1
+		if (STEP_X > 0)
+		{
+			tilesX = _mm_sub_epi32(tilesX, _mm_castps_si128(isStepX));
+		}
+		else
+		{
+			tilesX = _mm_add_epi32(tilesX, _mm_castps_si128(isStepX));
+		}
+		if (STEP_Y > 0)
+		{
+			tilesY = _mm_sub_epi32(tilesY, _mm_castps_si128(isStepY));
+		}
+		else
+		{
+			tilesY = _mm_add_epi32(tilesY, _mm_castps_si128(isStepY));
+		}
+
+		int hitCandidateMask = activeMask & _mm_movemask_ps(_mm_cmpge_ps(fwdDists, minHits));
+		if (hitCandidateMask != 0)
+		{
+			_mm_storeu_si128((__m128i*)tileXs, tilesX);
+			_mm_storeu_si128((__m128i*)tileYs, tilesY);
+			float crossingDists[4];
+			_mm_storeu_ps(crossingDists, fwdDists);
+			int xCrossingMask = _mm_movemask_ps(isXCrossing);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if ((hitCandidateMask & (1 << lane)) == 0 || !solidTiles.IsSetSafe(tileXs[lane], tileYs[lane], true))
+				{
+					continue;
+				}
+				VoxelRayHit& hit = m_hits[rayIndices[lane]];
+				hit.m_didImpact = true;
+				hit.m_impactDist = crossingDists[lane];
+				hit.m_impactNormal = (xCrossingMask & (1 << lane)) ? normalAfterXCrossing : normalAfterYCrossing;
+				activeMask &= ~(1 << lane);
+			}
+		}
+
+		fwdDistsAtNextXCrossing = _mm_add_ps(fwdDistsAtNextXCrossing, _mm_and_ps(isStepX, fwdDistsPerXCrossing));
+		fwdDistsAtNextYCrossing = _mm_add_ps(fwdDistsAtNextYCrossing, _mm_and_ps(isStepY, fwdDistsPerYCrossing));
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+
+class TileBitGrid;
+
+//-----------------------------------------------------------------------------------------------
+struct VoxelRayHit
+{
+	bool	m_didImpact = false;
+	bool	m_isStartInside = false;	// the start tile is solid, impact at distance 0
+	float	m_impactDist = 0.f;			// the ray length when there is no impact
+	Vec2	m_impactNormal;				// zero when the start is inside
+};
+
+//-----------------------------------------------------------------------------------------------
+// Fast voxel (Amanatides-Woo) raycasts against solid tiles, 4 rays at a time with SSE. Rays are
+// grouped by the quadrant of their direction and every quadrant has its own compiled walk, so the
+// tile steps and impact normals are constants and the lanes only differ in which axis they cross
+// next. Every lane does the same float math as Map::FastVoxelRaycast, so the hits are identical.
+// Distances are along the full ray direction, forward only holds its xy part. A clipped ray only
+// counts crossings between its clip distances (the map bounds, found once per ray up front) and
+// ends with no impact once it is past them.
+//
+class VoxelRayBatch
+{
+public:
+	void Clear();
+	int AddRay(Vec2 const& start, Vec2 const& forward, float length); // returns the ray index
+	int AddClippedRay(Vec2 const& start, Vec2 const& forward, float length, float minHitDist, float maxHitDist);
+	void Trace(TileBitGrid const& solidTiles); // outside of the padded grid counts as solid
+
+	int GetNumRays() const { return (int)m_hits.size(); }
+	VoxelRayHit const& GetHit(int rayIndex) const { return m_hits[rayIndex]; }
+
+private:
+	template <int STEP_X, int STEP_Y>
+	void TracePacket(TileBitGrid const& solidTiles, int const* rayIndices, int numRays);
+
+private:
+	std::vector<float>			m_startsX;
+	std::vector<float>			m_startsY;
+	std::vector<float>			m_forwardsX;
+	std::vector<float>			m_forwardsY;
+	std::vector<float>			m_lengths;
+	std::vector<float>			m_minHitDists;
+	std::vector<float>			m_maxHitDists;
+	std::vector<VoxelRayHit>	m_hits;
+	std::vector<int>			m_quadrantRays[4]; // +x+y, -x+y, -x-y, +x-y
+};
@@ -8,25 +8,22 @@
 #include "Engine/Core/Clock.hpp"
 #include "Engine/Core/DebugRender.hpp"
 #include "Engine/Math/MathUtils.hpp"
-#include "Engine/Math/Capsule2.hpp"
 #include "Engine/Math/RandomNumberGenerator.hpp"
 
-Weapon::Weapon(std::string weaponName)
+Weapon::Weapon(WeaponDefinition const* definition)
+	: m_definition(definition)
+	, m_animationClock(*(g_theGame->m_clock))
 {
-	m_definition = WeaponDefinition::GetByName(weaponName);
-
-	m_animationClock = new Clock(*(g_theGame->m_clock));
+	if (m_definition->m_projectileCount > 0)
+	{
+		m_projectileActorDefinition = ActorDefinition::GetByName(m_definition->m_projectileActor);
+	}
 	m_currentAnimation = m_definition->GetDefaultAnimationInfo();
 	//m_map = owner->m_map;
 	//m_actorHandle = owner->m_handle;
 }
 
 
-Weapon::~Weapon()
-{
-	delete m_animationClock;
-}
-
 bool Weapon::Fire(Actor* owner)
 {
 	if (m_fireTimer.IsStopped() || !m_fireTimer.HasPeriodElapsed())
@@ -97,35 +94,48 @@ void Weapon::FireRayWeapon(Actor* owner)
 		return;
 	}
 
+	// Rays are resolved with the other spatial queries after the actor update, hits are applied in fire order
+	Map* map = owner->m_map;
+	ActorHandle ownerHandle = owner->m_handle;
+	WeaponDefinition const* definition = m_definition;
+	Vec3 startPos = owner->GetFirePosition();
 	for (int i = 0; i < m_definition->m_rayCount; ++i)
 	{
 		Vec3 direction = GetRandomDirectionInCone(owner, m_definition->m_rayCone);
-		Vec3 startPos = owner->GetFirePosition();
-		RaycastResultWithActor result = owner->m_map->RaycastAll(startPos, direction, m_definition->m_rayRange, owner);
-		if (result.m_hitActor != nullptr && !result.m_hitActor->m_isDead)
-		{
-			// Damage and Impulse and Notify AI
-			float damage = g_rng.RollRandomFloatInRange(m_definition->m_rayDamage.m_min, m_definition->m_rayDamage.m_max);
-			result.m_hitActor->Damage(damage, owner);
-			result.m_hitActor->AddImpulse(direction * m_definition->m_rayImpulse);
-		}
+		map->m_spatialQueries.SubmitRaycast(startPos, direction, m_definition->m_rayRange, ownerHandle, [map, ownerHandle, definition, direction](SpatialQueryResult const& queryResult)
+			{
+				Actor* rayOwner = map->GetActorByHandle(ownerHandle);
+				if (rayOwner == nullptr)
+				{
+					return;
+				}
 
-		//DebugDrawRaycastResult3D(result);
+				RaycastResultWithActor const& result = queryResult.m_raycast;
+				if (result.m_hitActor != nullptr && !result.m_hitActor->m_isDead)
+				{
+					// Damage and Impulse and Notify AI
+					float damage = g_rng.RollRandomFloatInRange(definition->m_rayDamage.m_min, definition->m_rayDamage.m_max);
+					result.m_hitActor->Damage(damage, rayOwner);
+					result.m_hitActor->AddImpulse(direction * definition->m_rayImpulse);
+				}
 
-		if (result.m_hitActor) // Hit Actor
-		{
-			SpawnInfo info;
-			info.m_actor = "BloodSplatter";
-			info.m_position = result.m_impactPos;
-			owner->m_map->SpawnActor(info);
-		}
-		else if (result.m_didImpact) // Hit something other than actor 
-		{
-			SpawnInfo info;
-			info.m_actor = "BulletHit";
-			info.m_position = result.m_impactPos;
-			owner->m_map->SpawnActor(info);
-		}
+				//DebugDrawRaycastResult3D(result);
+
+				if (result.m_hitActor) // Hit Actor
+				{
+					SpawnInfo info;
+					info.m_actor = "BloodSplatter";
+					info.m_position = result.m_impactPos;
+					map->SpawnActor(info);
+				}
+				else if (result.m_didImpact) // Hit something other than actor 
+				{
+					SpawnInfo info;
+					info.m_actor = "BulletHit";
+					info.m_position = result.m_impactPos;
+					map->SpawnActor(info);
+				}
+			});
 	}
 
 }
@@ -143,11 +153,10 @@ void Weapon::FireProjectileWeapon(Actor* owner)
 		Vec3 startPos  = owner->GetFirePosition();
 
 		SpawnInfo info;
-		info.m_actor = m_definition->m_projectileActor;
 		info.m_position = startPos;
 		info.m_orientation = owner->m_orientation;
 		info.m_velocity = direction * m_definition->m_projectileSpeed;
-		Actor* projectileActor = owner->m_map->SpawnActor(info);
+		Actor* projectileActor = owner->m_map->SpawnActor(info, m_projectileActorDefinition);
 		projectileActor->m_owner = owner->m_handle;
 	}
 
@@ -161,31 +170,35 @@ void Weapon::FireMeleeWeapon(Actor* owner)
 		return;
 	}
 
+	// Opposing actors inside the sector come back after the actor update
+	Map* map = owner->m_map;
+	ActorHandle ownerHandle = owner->m_handle;
+	WeaponDefinition const* definition = m_definition;
 	for (int i = 0; i < m_definition->m_meleeCount; ++i)
 	{
-		int numActor = (int)owner->m_map->m_allActors.size();
-		for (int actorIndex = 0; actorIndex < numActor; ++actorIndex)
-		{
-			Actor* actor = owner->m_map->m_allActors[actorIndex];
-
-			if (actor == nullptr || actor->m_isDead)
-			{
-				continue;
-			}
-			// only attack opposing faction
-			if (!owner->IsOpposingFaction(actor->m_definition->m_faction))
+		map->m_spatialQueries.SubmitSector(ownerHandle, Vec2(owner->m_position.x, owner->m_position.y), owner->GetForwardNormal2D(), m_definition->m_meleeArc, m_definition->m_meleeRange,
+			[map, ownerHandle, definition](SpatialQueryResult const& queryResult)
 			{
-				continue;
-			}
+				Actor* meleeOwner = map->GetActorByHandle(ownerHandle);
+				if (meleeOwner == nullptr)
+				{
+					return;
+				}
 
-			if (IsPointInsideDirectedSector2D(Vec2(actor->m_position.x, actor->m_position.y), Vec2(owner->m_position.x, owner->m_position.y), owner->GetForwardNormal2D(), m_definition->m_meleeArc, m_definition->m_meleeRange))
-			{
-				float damage = g_rng.RollRandomFloatInRange(m_definition->m_meleeDamage.m_min, m_definition->m_meleeDamage.m_max);
-				actor->Damage(damage, owner);
-				Vec3 direction = (actor->m_position - owner->m_position).GetNormalized();
-				actor->AddImpulse(direction * m_definition->m_meleeImpulse);
-			}
-		}
+				for (ActorHandle const& actorHandle : queryResult.m_actors)
+				{
+					Actor* actor = map->GetActorByHandle(actorHandle);
+					if (actor == nullptr || actor->m_isDead)
+					{
+						continue;
+					}
+
+					float damage = g_rng.RollRandomFloatInRange(definition->m_meleeDamage.m_min, definition->m_meleeDamage.m_max);
+					actor->Damage(damage, meleeOwner);
+					Vec3 direction = (actor->m_position - meleeOwner->m_position).GetNormalized();
+					actor->AddImpulse(direction * definition->m_meleeImpulse);
+				}
+			});
 	}
 }
 
@@ -224,44 +237,50 @@ void Weapon::FireSpecialMeleeWeapon(Actor* owner)
 
 		Vec2 attackStartPos2D = Vec2(owner->m_position.x, owner->m_position.y);
 		Vec2 attackEndPos2D = attackStartPos2D + approximateMoveDistance * ownerDashDirection;
-		Capsule2 attackRange = Capsule2(attackStartPos2D, attackEndPos2D, m_definition->m_meleeRange);
 		if (g_isDebugDraw)
 		{
 			DebugAddWorldWireSphere(Vec3(attackStartPos2D, 0.5f), m_definition->m_meleeRange, 3.f, Rgba8::RED, Rgba8::OPAQUE_WHITE);
 			DebugAddWorldWireSphere(Vec3(attackEndPos2D, 0.5f), m_definition->m_meleeRange, 3.f, Rgba8::RED, Rgba8::OPAQUE_WHITE);
 		}
 
-		int numActor = (int)owner->m_map->m_allActors.size();
-		for (int actorIndex = 0; actorIndex < numActor; ++actorIndex)
-		{
-			Actor* actor = owner->m_map->m_allActors[actorIndex];
-
-			if (actor == nullptr || actor->m_isDead)
+		// Opposing actors inside the capsule come back after the actor update
+		Map* map = owner->m_map;
+		ActorHandle ownerHandle = owner->m_handle;
+		map->m_spatialQueries.SubmitCapsule(ownerHandle, attackStartPos2D, attackEndPos2D, m_definition->m_meleeRange, [map, ownerHandle](SpatialQueryResult const& queryResult)
 			{
-				continue;
-			}
-			// only attack opposing faction
-			if (!owner->IsOpposingFaction(actor->m_definition->m_faction))
-			{
-				continue;
-			}
-
-			if (IsPointInsideCapsule2D(Vec2(actor->m_position.x, actor->m_position.y), attackRange))
-			{
-				//float damage = g_rng.RollRandomFloatInRange(m_definition->m_meleeDamage.m_min, m_definition->m_meleeDamage.m_max);
-				float damage = 10000.f;
-				actor->Damage(damage, owner);
-				actor->SetInvisible();
-
-
-				if (player)
+				Actor* dashOwner = map->GetActorByHandle(ownerHandle);
+				if (dashOwner == nullptr)
 				{
-					player->SetThirdPersonTimer(owner->GetAnimationDuration("GloryKill"));
+					return;
 				}
+				Player* dashPlayer = nullptr;
+				if (dashOwner->m_controller && dashOwner->m_controller->IsPlayerController())
+				{
+					dashPlayer = dynamic_cast<Player*>(dashOwner->m_controller);
+				}
+
+				for (ActorHandle const& actorHandle : queryResult.m_actors)
+				{
+					Actor* actor = map->GetActorByHandle(actorHandle);
+					if (actor == nullptr || actor->m_isDead)
+					{
+						continue;
+					}
+
+					//float damage = g_rng.RollRandomFloatInRange(m_definition->m_meleeDamage.m_min, m_definition->m_meleeDamage.m_max);
+					float damage = 10000.f;
+					actor->Damage(damage, dashOwner);
+					actor->SetInvisible();
+
+
+					if (dashPlayer)
+					{
+						dashPlayer->SetThirdPersonTimer(dashOwner->GetAnimationDuration("GloryKill"));
+					}
 				
-				owner->PlayAnimation("GloryKill");
-			}
-		}
+					dashOwner->PlayAnimation("GloryKill");
+				}
+			});
 
 
 	}
@@ -316,7 +335,7 @@ void Weapon::PlayDefaultAnimation()
 	if (animInfo && animInfo != m_currentAnimation)
 	{
 		m_currentAnimation = animInfo;
-		m_animationClock->Reset();
+		m_animationClock.Reset();
 	}
 
 	if (IsSpecialWeapon())
@@ -338,7 +357,7 @@ bool Weapon::IsCurrentAnimationFinished() const
 		return false;
 	}
 
-	return m_currentAnimation->m_spriteAnimDef->GetDuration() < m_animationClock->GetTotalSeconds();
+	return m_currentAnimation->m_spriteAnimDef->GetDuration() < m_animationClock.GetTotalSeconds();
 }
 
 AABB2 Weapon::GetCurrentSpriteUV() const
@@ -348,7 +367,7 @@ AABB2 Weapon::GetCurrentSpriteUV() const
 		return AABB2();
 	}
 
-	SpriteDefinition const& spriteDef = m_currentAnimation->m_spriteAnimDef->GetSpriteDefAtTime((float)m_animationClock->GetTotalSeconds());
+	SpriteDefinition const& spriteDef = m_currentAnimation->m_spriteAnimDef->GetSpriteDefAtTime((float)m_animationClock.GetTotalSeconds());
 	return spriteDef.GetUVs();
 }
 
@@ -397,6 +416,6 @@ void Weapon::PlayAnimation(std::string const& name)
 	{
 		// can restart the same animation again
 		m_currentAnimation = animInfo;
-		m_animationClock->Reset();
+		m_animationClock.Reset();
 	}
 }
@@ -2,6 +2,7 @@
 //#include "Game/ActorHandle.hpp"
 #include "Game/GameCommon.hpp"
 //#include "Game/WeaponDefinition.hpp"
+#include "Engine/Core/Clock.hpp"
 #include "Engine/Core/Timer.hpp"
 #include "Engine/Audio/AudioSystem.hpp"
 #include <string>
@@ -12,8 +13,8 @@ struct WeaponAnimationInfo;
 class Weapon
 {
 public:
-	Weapon(std::string weaponName);
-	~Weapon();
+	explicit Weapon(WeaponDefinition const* definition); // built in place inside its Actor
+	Weapon(Weapon const& copy) = delete;
 	bool Fire(Actor* owner);
 
 	void OnEquip();
@@ -35,6 +36,7 @@ public:
 	float GetElapsedFractionOfSwitchWeapon() const;
 public:
 	WeaponDefinition const* m_definition = nullptr;
+	ActorDefinition const* m_projectileActorDefinition = nullptr; // resolved once, nullptr if the weapon fires no projectiles
 	//Map* m_map = nullptr;
 	//ActorHandle m_actorHandle = ActorHandle::INVALID;
 	WeaponAnimationInfo* m_currentAnimation = nullptr;
@@ -45,7 +47,7 @@ private:
 	void PlayAnimation(std::string const& name);
 
 private:
-	Clock* m_animationClock = nullptr;
+	Clock m_animationClock;
 	Timer m_fireTimer;
 	Timer m_switchWeaponTimer;
 	SoundPlaybackID m_firePlaybackID = MISSING_SOUND_ID;
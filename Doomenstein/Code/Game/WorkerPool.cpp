@@ -0,0 +1,105 @@
+#include "Game/WorkerPool.hpp"
+
+//-----------------------------------------------------------------------------------------------
+WorkerPool::WorkerPool(int numWorkers)
+{
+	for (int workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+	{
+		m_threads.emplace_back(&WorkerPool::WorkerThreadMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isQuitting = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+}
+
+int WorkerPool::GetNumThreads() const
+{
+	return (int)m_threads.size() + 1;
+}
+
+void WorkerPool::ParallelFor(int count, int batchSize, std::function<void(int begin, int end)> const& task)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (batchSize < 1)
+	{
+		batchSize = 1;
+	}
+	if (m_threads.empty() || count <= batchSize)
+	{
+		task(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_count = count;
+		m_batchSize = batchSize;
+		m_nextIndex = 0;
+		m_numBusyWorkers = (int)m_threads.size();
+		m_generation++;
+	}
+	m_workAvailable.notify_all();
+
+	RunBatches();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_workDone.wait(lock, [this]() { return m_numBusyWorkers == 0; });
+	m_task = nullptr;
+}
+
+//-----------------------------------------------------------------------------------------------
+void WorkerPool::WorkerThreadMain()
+{
+	unsigned int seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workAvailable.wait(lock, [this, seenGeneration]() { return m_isQuitting || m_generation != seenGeneration; });
+			if (m_isQuitting)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+		}
+
+		RunBatches();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_numBusyWorkers--;
+		}
+		m_workDone.notify_one();
+	}
+}
+
+void WorkerPool::RunBatches()
+{
+	while (true)
+	{
+		int begin = m_nextIndex.fetch_add(m_batchSize);
+		if (begin >= m_count)
+		{
+			return;
+		}
+		int end = (begin + m_batchSize < m_count) ? begin + m_batchSize : m_count;
+		(*m_task)(begin, end);
+	}
+}
+
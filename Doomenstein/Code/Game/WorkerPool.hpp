@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------
+// Small fork-join pool for the per-tick hot loops. ParallelFor hands out [begin, end) batches to
+// the worker threads and the calling thread, and returns once every batch is done. Only the main
+// thread may call it, and tasks must not call back into the pool.
+//
+class WorkerPool
+{
+public:
+	explicit WorkerPool(int numWorkers);
+	~WorkerPool();
+
+	int GetNumThreads() const; // workers + the calling thread
+	void ParallelFor(int count, int batchSize, std::function<void(int begin, int end)> const& task);
+
+private:
+	void WorkerThreadMain();
+	void RunBatches();
+
+private:
+	std::vector<std::thread>	m_threads;
+	std::mutex					m_mutex;
+	std::condition_variable		m_workAvailable;
+	std::condition_variable		m_workDone;
+	bool						m_isQuitting = false;
+	unsigned int				m_generation = 0;
+	int							m_numBusyWorkers = 0;
+
+	std::function<void(int, int)> const* m_task = nullptr;
+	int							m_count = 0;
+	int							m_batchSize = 1;
+	std::atomic<int>			m_nextIndex = 0;
+};
+